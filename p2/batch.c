@@ -0,0 +1,262 @@
+/**
+    @file batch.c
+    @author Scott Spencer (wsspence)
+
+    This file handles frame's batch mode.  Images are framed one after another with the same
+    row buffers, output buffer and cached weight maps, and a loader thread reads the next input
+    file into memory while the current image is being shaded, so reading and shading overlap.
+    An input that is the output of the image before it is only read once that output has been
+    written.
+*/
+
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing the POSIX thread functions we will use. */
+#include <pthread.h>
+/** Header file containing the fstat() function we will use. */
+#include <sys/stat.h>
+/** Header file containing the .ppm reading and writing functions. */
+#include "ppm.h"
+/** Header file containing the serial renderer. */
+#include "render.h"
+/** Header file containing the function prototypes for these functions. */
+#include "batch.h"
+
+/** Constant for the exit status when a line of the list is bad. */
+#define ERRLIST 1
+/** Constant for the number of bytes we first make room for when a file's size isn't known. */
+#define CHUNK ( 1 << 16 )
+
+/** Structure holding one image of the batch, its file names and its input file's contents. */
+typedef struct {
+    /** Name of the input file. */
+    char *inName;
+    /** Name of the output file. */
+    char *outName;
+    /** Contents of the input file. */
+    char *data;
+    /** Number of bytes in the input file. */
+    size_t size;
+    /** Number of bytes data has room for, kept from one image to the next. */
+    size_t capacity;
+    /** 0 if the input file was read, otherwise ERRIO. */
+    int status;
+} Slot;
+
+/**
+    This function reads the whole input file of a slot into the slot's data buffer, growing the
+    buffer if it's too small.  It is run by the loader thread.
+
+    @param arg void pointer to the Slot to load.
+    @return void pointer that is always NULL.
+*/
+static void *loadSlot( void *arg ) {
+    Slot *slot = arg;
+    slot->size = 0;
+    slot->status = ERRIO;
+
+    FILE *fp = fopen(slot->inName, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    //Start with room for the whole file if we can tell how big it is.
+    struct stat info;
+    size_t want = CHUNK;
+    if (fstat(fileno(fp), &info) == 0 && info.st_size > 0) {
+        want = info.st_size + 1;
+    }
+
+    while (true) {
+        if (slot->capacity < want) {
+            char *data = realloc(slot->data, want);
+            if (data == NULL) {
+                fclose(fp);
+                return NULL;
+            }
+            slot->data = data;
+            slot->capacity = want;
+        }
+        slot->size += fread(slot->data + slot->size, 1, slot->capacity - slot->size, fp);
+        if (slot->size < slot->capacity) {
+            break;
+        }
+        want = slot->capacity * 2;
+    }
+
+    if (!ferror(fp)) {
+        slot->status = 0;
+    }
+    fclose(fp);
+    return NULL;
+}
+
+/**
+    This function reads the next pair of file names from the list into a slot, skipping blank
+    lines.  A line that doesn't hold exactly two names is reported and skipped.
+
+    @param list FILE pointer to the list of file names.
+    @param slot Slot pointer the names are stored in.
+    @param status int pointer set to ERRLIST if a bad line is found and it's still 0.
+    @return bool false once the end of the list is reached.
+*/
+static bool nextNames( FILE *list, Slot *slot, int *status ) {
+    static char *line = NULL;
+    static size_t lineSize = 0;
+
+    while (getline(&line, &lineSize, list) != -1) {
+        //Both names fit in buffers as long as the line, plus a byte to spot a third name.
+        char *inName = realloc(slot->inName, lineSize);
+        char *outName = realloc(slot->outName, lineSize);
+        char extra[2];
+        if (inName != NULL) {
+            slot->inName = inName;
+        }
+        if (outName != NULL) {
+            slot->outName = outName;
+        }
+        if (inName == NULL || outName == NULL) {
+            break;
+        }
+
+        int count = sscanf(line, "%s %s %1s", inName, outName, extra);
+        if (count == 2) {
+            return true;
+        }
+        if (count > 0) {
+            fprintf(stderr, "Invalid batch line: %s", line);
+            if (*status == 0) {
+                *status = ERRLIST;
+            }
+        }
+    }
+
+    free(line);
+    line = NULL;
+    lineSize = 0;
+    return false;
+}
+
+/**
+    This function decides whether an image's input file might be the output file of the image
+    before it, in which case it can't be read until that output is written.  An input that
+    doesn't exist yet is treated as a match too, since the output may be about to create it.
+
+    @param inName char pointer to the name of the input file.
+    @param outName char pointer to the name of the output file written before it.
+    @return bool true if the input has to wait for the output to be written.
+*/
+static bool readsOutput( const char *inName, const char *outName ) {
+    struct stat inInfo, outInfo;
+    if (strcmp(inName, outName) == 0 || stat(inName, &inInfo) != 0) {
+        return true;
+    }
+    return stat(outName, &outInfo) == 0 && inInfo.st_dev == outInfo.st_dev &&
+           inInfo.st_ino == outInfo.st_ino;
+}
+
+/**
+    This function frames the image held in a slot and writes it to the slot's output file.
+
+    @param slot Slot pointer to the image.
+    @param border unsigned char array holding the frame's red, green and blue values.
+    @param buffers RowBuffers pointer to the row buffers to reuse.
+    @param outBuffer char array of IOBUFFER bytes to use as the output file's stdio buffer.
+    @return int 0 on success, otherwise the image's exit status.
+*/
+static int frameSlot( Slot *slot, const unsigned char *border, RowBuffers *buffers,
+                      char *outBuffer ) {
+    if (slot->status != 0) {
+        fprintf(stderr, "Can't open file: %s\n", slot->inName);
+        return slot->status;
+    }
+    if (slot->size == 0) {
+        fprintf(stderr, "Invalid image: %s\n", slot->inName);
+        return ERRFILE;
+    }
+
+    //Parse the image straight out of the memory the loader read it into.
+    Reader in;
+    memoryReader(&in, slot->data, slot->size);
+    PPMHeader header;
+    int status = readHeader(&in, &header);
+    if (status == 0) {
+        FILE *out = fopen(slot->outName, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "Can't open file: %s\n", slot->outName);
+            return ERRIO;
+        }
+        setvbuf(out, outBuffer, _IOFBF, IOBUFFER);
+        status = renderStream(&in, &header, out, border, buffers);
+        if (fclose(out) != 0 && status == 0) {
+            status = ERRIO;
+        }
+    }
+    if (status != 0 && status != ERRIO) {
+        fprintf(stderr, "Invalid image: %s\n", slot->inName);
+    }
+    return status;
+}
+
+/**
+    This function is documented in batch.h.
+*/
+int renderBatch( FILE *list, const unsigned char *border ) {
+    Slot slots[2];
+    memset(slots, 0, sizeof(slots));
+    RowBuffers buffers = { NULL, NULL, NULL, 0, 0, 0 };
+    char *outBuffer = malloc(IOBUFFER);
+    if (outBuffer == NULL) {
+        return ERRIO;
+    }
+
+    int status = 0;
+    int current = 0;
+    bool more = nextNames(list, &slots[current], &status);
+    if (more) {
+        loadSlot(&slots[current]);
+    }
+
+    while (more) {
+        //Start reading the next image, if there is one, before shading this one, unless it
+        //reads the file this one is about to write.
+        Slot *next = &slots[1 - current];
+        bool loading = false;
+        bool chained = false;
+        pthread_t loader;
+        more = nextNames(list, next, &status);
+        if (more) {
+            chained = readsOutput(next->inName, slots[current].outName);
+            if (!chained) {
+                loading = pthread_create(&loader, NULL, loadSlot, next) == 0;
+                if (!loading) {
+                    loadSlot(next);
+                }
+            }
+        }
+
+        int result = frameSlot(&slots[current], border, &buffers, outBuffer);
+        if (status == 0) {
+            status = result;
+        }
+
+        if (loading) {
+            pthread_join(loader, NULL);
+        }
+        if (chained) {
+            loadSlot(next);
+        }
+        current = 1 - current;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        free(slots[i].inName);
+        free(slots[i].outName);
+        free(slots[i].data);
+    }
+    freeRowBuffers(&buffers);
+    free(outBuffer);
+    return status;
+}
@@ -0,0 +1,28 @@
+/**
+    @file batch.h
+    @author Scott Spencer (wsspence)
+
+    This header file contains the function prototype for frame's batch mode, which frames a
+    whole list of images in one process instead of starting a new process for every image.
+*/
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+
+/**
+    This function frames every image named in a list.  Each line of the list holds an input
+    file name and an output file name, separated by whitespace, and blank lines are skipped.
+    While one image is being shaded, the next one is already being read in by another thread.
+    An image that can't be framed is reported on standard error and the rest of the list is
+    still processed.
+
+    @param list FILE pointer to the list of file names.
+    @param border unsigned char array holding the frame's red, green and blue values.
+    @return int 0 if every image was framed, otherwise the exit status for the first failure.
+*/
+int renderBatch( FILE *list, const unsigned char *border );
+
+#endif
@@ -0,0 +1,53 @@
+#!/bin/bash
+# Benchmark frame on synthetic images.  The arguments are the image sizes
+# to try, in megapixels (1 10 50 200 if none are given).  The images are
+# generated into the bench directory the first time they're needed and
+# kept for later runs, since the big ones take a while to write.
+SIZES=${*:-1 10 50 200}
+FAIL=0
+
+mkdir -p bench
+
+# Function to time one run of the frame program over an image and print
+# frame's report of its throughput, stage times and peak memory.
+benchFrame() {
+  IMAGE=$1
+  LABEL=$2
+  shift 2
+
+  printf "%-24s " "$LABEL"
+  if ! ./frame -s "$@" $IMAGE bench/output.ppm 2>&1 >/dev/null ; then
+      echo "**** Frame failed on $IMAGE"
+      FAIL=1
+  fi
+  rm -f bench/output.ppm
+}
+
+for MP in $SIZES ; do
+    # Keep a 4:3 shape, like most photos.
+    read WIDTH HEIGHT < <(awk -v mp=$MP 'BEGIN { w = int(sqrt(mp * 1e6 * 4 / 3));
+                                              print w, int(mp * 1e6 / w) }')
+
+    for FORMAT in P6 P3 ; do
+        IMAGE=bench/bench-$MP-$FORMAT.ppm
+        if [ ! -f $IMAGE ] ; then
+            echo "Generating $IMAGE (${WIDTH}x$HEIGHT)"
+            if ! ./genppm $WIDTH $HEIGHT $FORMAT > $IMAGE ; then
+                rm -f $IMAGE
+                echo "**** Couldn't generate $IMAGE"
+                FAIL=1
+                continue
+            fi
+        fi
+
+        benchFrame $IMAGE "$MP MP $FORMAT"
+        if [ $FORMAT = P6 ] ; then
+            benchFrame $IMAGE "$MP MP $FORMAT threaded" -t 0
+        fi
+    done
+done
+
+if [ $FAIL -ne 0 ]; then
+  echo "**** There were failing runs"
+  exit 1
+fi
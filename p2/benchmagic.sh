@@ -0,0 +1,54 @@
+#!/bin/bash
+# Benchmark magic on synthetic text.  The arguments are the corpus sizes to
+# try, in megabytes (1 10 100 if none are given).  Each size is generated
+# with a few mixes of numbers, identifiers and line lengths into the bench
+# directory the first time it's needed, and kept for later runs.
+SIZES=${*:-1 10 100}
+FAIL=0
+
+# The mixes, as name, percentage of words that are numbers, average line
+# length and percentage of words that are identifiers with digits.
+MIXES="sparse:2:80:10 typical:10:80:20 dense:40:40:30 long-lines:10:4000:20"
+
+mkdir -p bench
+
+# Function to time one run of the magic program over a corpus and print
+# magic's report of its throughput and system calls per megabyte.
+benchMagic() {
+  LABEL=$1
+  shift
+
+  printf "%-32s " "$LABEL"
+  if ! ./magic -r "$@" 2>&1 >/dev/null ; then
+      echo "**** Magic failed on $LABEL"
+      FAIL=1
+  fi
+}
+
+for MB in $SIZES ; do
+    for MIX in $MIXES ; do
+        IFS=: read NAME DIGITS LINE IDENTIFIERS <<< "$MIX"
+        CORPUS=bench/corpus-$MB-$NAME.txt
+        if [ ! -f $CORPUS ] ; then
+            echo "Generating $CORPUS"
+            if ! ./gentext $MB $DIGITS $LINE $IDENTIFIERS > $CORPUS ; then
+                rm -f $CORPUS
+                echo "**** Couldn't generate $CORPUS"
+                FAIL=1
+                continue
+            fi
+        fi
+
+        benchMagic "$MB MB $NAME" < $CORPUS
+        benchMagic "$MB MB $NAME mapped" -t 0 $CORPUS
+        if [ $NAME = typical ] ; then
+            benchMagic "$MB MB $NAME offsets" -o offsets < $CORPUS
+            benchMagic "$MB MB $NAME statistics" -s $CORPUS
+        fi
+    done
+done
+
+if [ $FAIL -ne 0 ]; then
+  echo "**** There were failing runs"
+  exit 1
+fi
@@ -0,0 +1,469 @@
+/**
+    @file blend.c
+    @author Scott Spencer (wsspence)
+
+    This file holds the kernels that blend the frame color into a run of pixels.  The SIMD
+    kernels widen each color sample to a 32 bit lane, give it its pixel's blend factor, and do
+    the 64 bit multiply-add-round-shift from shade() two or four lanes at a time, so their
+    results are bit-for-bit the same as the plain C kernel's.  The two byte kernels swap each
+    sample's bytes around as they load and store it, and otherwise do exactly the same math.
+*/
+
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing the number of samples in a pixel and the largest byte intensity. */
+#include "ppm.h"
+/** Header file containing the function prototypes for these functions. */
+#include "blend.h"
+
+//The SIMD kernels need GCC style target attributes and an x86 processor.
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+/** Defined when the SSE2 and AVX2 kernels are compiled in. */
+#define BLEND_X86
+/** Header file containing the SSE2 and AVX2 intrinsics we will use. */
+#include <immintrin.h>
+#endif
+
+/** Type for a pointer to one of the blend kernels. */
+typedef void (*BlendKernel)( unsigned char *pixels, const uint32_t *factors, int count,
+                             const uint16_t *border );
+
+/**
+    This function shades the parameterized color by altering its value based on the percentage
+    of distance its pixel is from the edge of the frame.  Towards the edges the pixels in the frame
+    become entirely the frame color, but closer to the window they are mostly their original color
+    with a small percentage of the frame color added.
+
+    @param color int representing the RGB color that will have weight applied to it.
+    @param borderColor int representing the RGB color of our frame.
+    @param factor uint32_t the pixel's fixed-point weight, from 0 up to BLEND_ONE.
+    @return int the shaded color.
+*/
+static int shade( int color, int borderColor, uint32_t factor ) {
+    //Add frame color times some weight, w plus the original pixel color times ( 1 - w ).  Round
+    //to the nearest int and that will be the new shaded color for that pixel.
+    return ( borderColor * (uint64_t) factor + color * ( BLEND_ONE - factor ) + BLEND_HALF )
+           >> BLEND_SHIFT;
+}
+
+/**
+    This function is the plain C kernel, which shades a pixel at a time.  It's also used for
+    the last few pixels of a run that don't fill a whole SIMD block.
+
+    @param pixels unsigned char array holding the run's interleaved RGB values.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param border uint16_t array holding the frame's red, green and blue values.
+    @return void
+*/
+static void blendScalar( unsigned char *pixels, const uint32_t *factors, int count,
+                         const uint16_t *border ) {
+    for (int x = 0; x < count; x++) {
+        unsigned char *pixel = pixels + x * RGBNUM;
+        if (factors[x] != 0) {
+            pixel[0] = shade(pixel[0], border[0], factors[x]);
+            pixel[1] = shade(pixel[1], border[1], factors[x]);
+            pixel[2] = shade(pixel[2], border[2], factors[x]);
+        }
+    }
+}
+
+/**
+    This function is the plain C kernel for two byte samples.
+
+    @param pixels unsigned char array holding the run's interleaved RGB samples.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param border uint16_t array holding the frame's red, green and blue values.
+    @return void
+*/
+static void blendWideScalar( unsigned char *pixels, const uint32_t *factors, int count,
+                             const uint16_t *border ) {
+    for (int x = 0; x < count; x++) {
+        if (factors[x] != 0) {
+            for (int i = 0; i < RGBNUM; i++) {
+                unsigned char *sample = pixels + ( x * RGBNUM + i ) * 2;
+                int color = shade(sample[0] << 8 | sample[1], border[i], factors[x]);
+                sample[0] = color >> 8;
+                sample[1] = color;
+            }
+        }
+    }
+}
+
+#ifdef BLEND_X86
+
+/**
+    This function does shade() on four 32 bit lanes at once.  _mm_mul_epu32 only multiplies the
+    even lanes, so the odd lanes are shifted down, done separately, and shifted back.
+
+    @param color __m128i holding four color samples.
+    @param border __m128i holding the frame color for each sample.
+    @param factor __m128i holding the blend factor for each sample.
+    @return __m128i holding the four shaded samples.
+*/
+__attribute__(( target( "sse2" ) ))
+static inline __m128i shadeSSE2( __m128i color, __m128i border, __m128i factor ) {
+    //BLEND_ONE is 0x80000000 as a 32 bit lane, so ONE - factor fits in an unsigned lane.
+    __m128i complement = _mm_sub_epi32(_mm_set1_epi32(INT32_MIN), factor);
+    __m128i half = _mm_set1_epi64x(BLEND_HALF);
+
+    __m128i even = _mm_add_epi64(_mm_mul_epu32(border, factor), _mm_mul_epu32(color, complement));
+    __m128i odd = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(border, 32),
+                                              _mm_srli_epi64(factor, 32)),
+                                _mm_mul_epu32(_mm_srli_epi64(color, 32),
+                                              _mm_srli_epi64(complement, 32)));
+    even = _mm_srli_epi64(_mm_add_epi64(even, half), BLEND_SHIFT);
+    odd = _mm_srli_epi64(_mm_add_epi64(odd, half), BLEND_SHIFT);
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+/**
+    This function is the SSE2 kernel, which shades four pixels (twelve samples) at a time.
+
+    @param pixels unsigned char array holding the run's interleaved RGB values.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param border uint16_t array holding the frame's red, green and blue values.
+    @return void
+*/
+__attribute__(( target( "sse2" ) ))
+static void blendSSE2( unsigned char *pixels, const uint32_t *factors, int count,
+                       const uint16_t *border ) {
+    //The frame color repeats every three samples, so twelve samples need three patterns.
+    __m128i border0 = _mm_setr_epi32(border[0], border[1], border[2], border[0]);
+    __m128i border1 = _mm_setr_epi32(border[1], border[2], border[0], border[1]);
+    __m128i border2 = _mm_setr_epi32(border[2], border[0], border[1], border[2]);
+    __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        unsigned char *block = pixels + x * RGBNUM;
+
+        //Give each of the twelve samples its pixel's factor.
+        __m128i factor = _mm_loadu_si128((const __m128i *) (factors + x));
+        __m128i factor0 = _mm_shuffle_epi32(factor, _MM_SHUFFLE(1, 0, 0, 0));
+        __m128i factor1 = _mm_shuffle_epi32(factor, _MM_SHUFFLE(2, 2, 1, 1));
+        __m128i factor2 = _mm_shuffle_epi32(factor, _MM_SHUFFLE(3, 3, 3, 2));
+
+        //Load the twelve samples without reading past the run, and widen them to 32 bits.
+        int32_t tail;
+        memcpy(&tail, block + 8, sizeof(tail));
+        __m128i bytes = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *) block),
+                                           _mm_cvtsi32_si128(tail));
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+        __m128i color0 = shadeSSE2(_mm_unpacklo_epi16(low, zero), border0, factor0);
+        __m128i color1 = shadeSSE2(_mm_unpackhi_epi16(low, zero), border1, factor1);
+        __m128i color2 = shadeSSE2(_mm_unpacklo_epi16(high, zero), border2, factor2);
+
+        //Narrow back down to bytes and store the twelve samples.
+        bytes = _mm_packus_epi16(_mm_packs_epi32(color0, color1), _mm_packs_epi32(color2, color2));
+        _mm_storel_epi64((__m128i *) block, bytes);
+        tail = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+        memcpy(block + 8, &tail, sizeof(tail));
+    }
+    blendScalar(pixels + x * RGBNUM, factors + x, count - x, border);
+}
+
+/**
+    This function swaps the two bytes of every 16 bit lane, turning most significant byte first
+    samples into the processor's order and back.
+
+    @param words __m128i holding eight 16 bit samples.
+    @return __m128i holding the samples with their bytes swapped.
+*/
+__attribute__(( target( "sse2" ) ))
+static inline __m128i swapSSE2( __m128i words ) {
+    return _mm_or_si128(_mm_slli_epi16(words, 8), _mm_srli_epi16(words, 8));
+}
+
+/**
+    This function narrows eight shaded 32 bit samples to 16 bits.  SSE2 can only pack with
+    signed saturation, so the samples are moved down into the signed range for the pack and
+    back up again afterwards.
+
+    @param low __m128i holding the first four shaded samples.
+    @param high __m128i holding the last four shaded samples.
+    @return __m128i holding the eight samples as 16 bit lanes.
+*/
+__attribute__(( target( "sse2" ) ))
+static inline __m128i narrowSSE2( __m128i low, __m128i high ) {
+    __m128i bias = _mm_set1_epi32(0x8000);
+    __m128i words = _mm_packs_epi32(_mm_sub_epi32(low, bias), _mm_sub_epi32(high, bias));
+    return _mm_xor_si128(words, _mm_set1_epi16(INT16_MIN));
+}
+
+/**
+    This function is the SSE2 kernel for two byte samples, which shades four pixels (twelve
+    samples) at a time.
+
+    @param pixels unsigned char array holding the run's interleaved RGB samples.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param border uint16_t array holding the frame's red, green and blue values.
+    @return void
+*/
+__attribute__(( target( "sse2" ) ))
+static void blendWideSSE2( unsigned char *pixels, const uint32_t *factors, int count,
+                           const uint16_t *border ) {
+    __m128i border0 = _mm_setr_epi32(border[0], border[1], border[2], border[0]);
+    __m128i border1 = _mm_setr_epi32(border[1], border[2], border[0], border[1]);
+    __m128i border2 = _mm_setr_epi32(border[2], border[0], border[1], border[2]);
+    __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        unsigned char *block = pixels + x * RGBNUM * 2;
+
+        __m128i factor = _mm_loadu_si128((const __m128i *) (factors + x));
+        __m128i factor0 = _mm_shuffle_epi32(factor, _MM_SHUFFLE(1, 0, 0, 0));
+        __m128i factor1 = _mm_shuffle_epi32(factor, _MM_SHUFFLE(2, 2, 1, 1));
+        __m128i factor2 = _mm_shuffle_epi32(factor, _MM_SHUFFLE(3, 3, 3, 2));
+
+        //The twelve samples are 24 bytes, a whole load and a half load.
+        __m128i low = swapSSE2(_mm_loadu_si128((const __m128i *) block));
+        __m128i high = swapSSE2(_mm_loadl_epi64((const __m128i *) (block + 16)));
+
+        __m128i color0 = shadeSSE2(_mm_unpacklo_epi16(low, zero), border0, factor0);
+        __m128i color1 = shadeSSE2(_mm_unpackhi_epi16(low, zero), border1, factor1);
+        __m128i color2 = shadeSSE2(_mm_unpacklo_epi16(high, zero), border2, factor2);
+
+        _mm_storeu_si128((__m128i *) block, swapSSE2(narrowSSE2(color0, color1)));
+        _mm_storel_epi64((__m128i *) (block + 16), swapSSE2(narrowSSE2(color2, color2)));
+    }
+    blendWideScalar(pixels + x * RGBNUM * 2, factors + x, count - x, border);
+}
+
+/**
+    This function does shade() on eight 32 bit lanes at once, the same way shadeSSE2() does.
+
+    @param color __m256i holding eight color samples.
+    @param border __m256i holding the frame color for each sample.
+    @param factor __m256i holding the blend factor for each sample.
+    @return __m256i holding the eight shaded samples.
+*/
+__attribute__(( target( "avx2" ) ))
+static inline __m256i shadeAVX2( __m256i color, __m256i border, __m256i factor ) {
+    __m256i complement = _mm256_sub_epi32(_mm256_set1_epi32(INT32_MIN), factor);
+    __m256i half = _mm256_set1_epi64x(BLEND_HALF);
+
+    __m256i even = _mm256_add_epi64(_mm256_mul_epu32(border, factor),
+                                    _mm256_mul_epu32(color, complement));
+    __m256i odd = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(border, 32),
+                                                    _mm256_srli_epi64(factor, 32)),
+                                   _mm256_mul_epu32(_mm256_srli_epi64(color, 32),
+                                                    _mm256_srli_epi64(complement, 32)));
+    even = _mm256_srli_epi64(_mm256_add_epi64(even, half), BLEND_SHIFT);
+    odd = _mm256_srli_epi64(_mm256_add_epi64(odd, half), BLEND_SHIFT);
+    return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+}
+
+/**
+    This function narrows eight shaded 32 bit samples to bytes and stores them.
+
+    @param block unsigned char pointer to where the eight samples go.
+    @param color __m256i holding the eight shaded samples.
+    @return void
+*/
+__attribute__(( target( "avx2" ) ))
+static inline void storeAVX2( unsigned char *block, __m256i color ) {
+    __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(color),
+                                    _mm256_extracti128_si256(color, 1));
+    _mm_storel_epi64((__m128i *) block, _mm_packus_epi16(words, words));
+}
+
+/**
+    This function is the AVX2 kernel, which shades eight pixels (twenty-four samples) at a time.
+
+    @param pixels unsigned char array holding the run's interleaved RGB values.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param border uint16_t array holding the frame's red, green and blue values.
+    @return void
+*/
+__attribute__(( target( "avx2" ) ))
+static void blendAVX2( unsigned char *pixels, const uint32_t *factors, int count,
+                       const uint16_t *border ) {
+    //The frame color repeats every three samples, so twenty-four samples need three patterns.
+    __m256i border0 = _mm256_setr_epi32(border[0], border[1], border[2], border[0],
+                                        border[1], border[2], border[0], border[1]);
+    __m256i border1 = _mm256_setr_epi32(border[2], border[0], border[1], border[2],
+                                        border[0], border[1], border[2], border[0]);
+    __m256i border2 = _mm256_setr_epi32(border[1], border[2], border[0], border[1],
+                                        border[2], border[0], border[1], border[2]);
+
+    //Which of the eight pixels each of the twenty-four samples belongs to.
+    __m256i spread0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+    __m256i spread1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+    __m256i spread2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        unsigned char *block = pixels + x * RGBNUM;
+
+        __m256i factor = _mm256_loadu_si256((const __m256i *) (factors + x));
+        __m256i color0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) block));
+        __m256i color1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (block + 8)));
+        __m256i color2 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (block + 16)));
+
+        color0 = shadeAVX2(color0, border0, _mm256_permutevar8x32_epi32(factor, spread0));
+        color1 = shadeAVX2(color1, border1, _mm256_permutevar8x32_epi32(factor, spread1));
+        color2 = shadeAVX2(color2, border2, _mm256_permutevar8x32_epi32(factor, spread2));
+
+        storeAVX2(block, color0);
+        storeAVX2(block + 8, color1);
+        storeAVX2(block + 16, color2);
+    }
+    blendScalar(pixels + x * RGBNUM, factors + x, count - x, border);
+}
+
+/**
+    This function loads eight two byte samples and widens them to 32 bit lanes.
+
+    @param block unsigned char pointer to the eight samples.
+    @return __m256i holding the eight samples.
+*/
+__attribute__(( target( "avx2" ) ))
+static inline __m256i loadWideAVX2( const unsigned char *block ) {
+    __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    __m128i words = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) block), swap);
+    return _mm256_cvtepu16_epi32(words);
+}
+
+/**
+    This function narrows eight shaded 32 bit samples to two byte samples and stores them.
+
+    @param block unsigned char pointer to where the eight samples go.
+    @param color __m256i holding the eight shaded samples.
+    @return void
+*/
+__attribute__(( target( "avx2" ) ))
+static inline void storeWideAVX2( unsigned char *block, __m256i color ) {
+    __m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(color),
+                                     _mm256_extracti128_si256(color, 1));
+    _mm_storeu_si128((__m128i *) block, _mm_shuffle_epi8(words, swap));
+}
+
+/**
+    This function is the AVX2 kernel for two byte samples, which shades eight pixels
+    (twenty-four samples) at a time.
+
+    @param pixels unsigned char array holding the run's interleaved RGB samples.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param border uint16_t array holding the frame's red, green and blue values.
+    @return void
+*/
+__attribute__(( target( "avx2" ) ))
+static void blendWideAVX2( unsigned char *pixels, const uint32_t *factors, int count,
+                           const uint16_t *border ) {
+    __m256i border0 = _mm256_setr_epi32(border[0], border[1], border[2], border[0],
+                                        border[1], border[2], border[0], border[1]);
+    __m256i border1 = _mm256_setr_epi32(border[2], border[0], border[1], border[2],
+                                        border[0], border[1], border[2], border[0]);
+    __m256i border2 = _mm256_setr_epi32(border[1], border[2], border[0], border[1],
+                                        border[2], border[0], border[1], border[2]);
+    __m256i spread0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+    __m256i spread1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+    __m256i spread2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        unsigned char *block = pixels + x * RGBNUM * 2;
+
+        __m256i factor = _mm256_loadu_si256((const __m256i *) (factors + x));
+        __m256i color0 = shadeAVX2(loadWideAVX2(block), border0,
+                                   _mm256_permutevar8x32_epi32(factor, spread0));
+        __m256i color1 = shadeAVX2(loadWideAVX2(block + 16), border1,
+                                   _mm256_permutevar8x32_epi32(factor, spread1));
+        __m256i color2 = shadeAVX2(loadWideAVX2(block + 32), border2,
+                                   _mm256_permutevar8x32_epi32(factor, spread2));
+
+        storeWideAVX2(block, color0);
+        storeWideAVX2(block + 16, color1);
+        storeWideAVX2(block + 32, color2);
+    }
+    blendWideScalar(pixels + x * RGBNUM * 2, factors + x, count - x, border);
+}
+
+#endif
+
+/** The kernel blendRow() uses for one byte samples, the plain C one until chooseKernel(). */
+static BlendKernel kernel = blendScalar;
+/** The kernel blendRow() uses for two byte samples, the plain C one until chooseKernel(). */
+static BlendKernel wideKernel = blendWideScalar;
+
+/**
+    This function is documented in blend.h.
+*/
+void scaleBorder( const unsigned char *border, int maxIntensity, uint16_t *scaled ) {
+    for (int i = 0; i < RGBNUM; i++) {
+        scaled[i] = ( border[i] * maxIntensity + WEIGHT / 2 ) / WEIGHT;
+    }
+}
+
+/**
+    This function is documented in blend.h.
+*/
+bool chooseKernel( const char *want ) {
+#ifdef BLEND_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool sse2 = __builtin_cpu_supports("sse2");
+#else
+    bool avx2 = false;
+    bool sse2 = false;
+#endif
+
+    //With no name given, take the fastest kernel we can run.
+    if (want == NULL) {
+        want = avx2 ? "avx2" : sse2 ? "sse2" : "scalar";
+    }
+
+    if (strcmp(want, "scalar") == 0) {
+        kernel = blendScalar;
+        wideKernel = blendWideScalar;
+    }
+#ifdef BLEND_X86
+    else if (strcmp(want, "sse2") == 0 && sse2) {
+        kernel = blendSSE2;
+        wideKernel = blendWideSSE2;
+    }
+    else if (strcmp(want, "avx2") == 0 && avx2) {
+        kernel = blendAVX2;
+        wideKernel = blendWideAVX2;
+    }
+#endif
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+    This function is documented in blend.h.
+*/
+void blendRow( unsigned char *pixels, const uint32_t *factors, int count, int depth,
+               const uint16_t *border ) {
+    if (depth == 1) {
+        kernel(pixels, factors, count, border);
+    }
+    else {
+        wideKernel(pixels, factors, count, border);
+    }
+}
+
+/**
+    This function is documented in blend.h.
+*/
+void shadeRow( const WeightMap *map, int y, unsigned char *row, uint32_t *factors, int depth,
+               const uint16_t *border ) {
+    int start;
+    int end;
+    expandRow(map, y, factors, &start, &end);
+    blendRow(row, factors, start, depth, border);
+    blendRow(row + (size_t) end * RGBNUM * depth, factors + end, map->width - end, depth, border);
+}
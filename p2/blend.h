@@ -0,0 +1,75 @@
+/**
+    @file blend.h
+    @author Scott Spencer (wsspence)
+
+    This header file contains the function prototypes for the kernels that blend the frame color
+    into a run of pixels.  There is a plain C kernel that works everywhere, plus SSE2 and AVX2
+    kernels on x86 processors, and the best one the processor supports is picked when the
+    program starts.  Every kernel does the same fixed-point math, so they all give exactly the
+    same colors.  Each kernel comes in two widths, one for images with one byte samples and one
+    for images with two byte (most significant byte first) samples.
+*/
+
+#ifndef _BLEND_H_
+#define _BLEND_H_
+
+/** Header file containing boolean operations we will use. */
+#include <stdbool.h>
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+/** Header file containing the weight map type. */
+#include "weight.h"
+
+/**
+    This function scales the frame color, which is given out of 255, to an image's maximum
+    intensity, rounding to the nearest int.
+
+    @param border unsigned char array holding the frame's red, green and blue values.
+    @param maxIntensity int the image's maximum intensity.
+    @param scaled uint16_t array the scaled red, green and blue values are stored in.
+    @return void
+*/
+void scaleBorder( const unsigned char *border, int maxIntensity, uint16_t *scaled );
+
+/**
+    This function picks the kernels blendRow() will use.
+
+    @param name char pointer to "scalar", "sse2" or "avx2", or NULL for the fastest kernel the
+                processor supports.
+    @return bool false if there's no kernel by that name or the processor can't run it.
+*/
+bool chooseKernel( const char *name );
+
+/**
+    This function blends the frame color into a run of pixels in place.  Each pixel becomes
+    the frame color times its blend factor plus its original color times one minus the factor,
+    rounded to the nearest int.  A pixel with a factor of zero keeps its original color.
+
+    @param pixels unsigned char array holding the run's interleaved RGB samples.
+    @param factors uint32_t array holding the blend factor for every pixel in the run.
+    @param count int the number of pixels in the run.
+    @param depth int the number of bytes in each sample, 1 or 2.
+    @param border uint16_t array holding the frame's red, green and blue values, already scaled
+                  to the image's maximum intensity.
+    @return void
+*/
+void blendRow( unsigned char *pixels, const uint32_t *factors, int count, int depth,
+               const uint16_t *border );
+
+/**
+    This function shades one row of the image in place.  Only the spans on either side of the
+    frame's window are blended, the pixels inside it are left exactly as they were read.
+
+    @param map WeightMap pointer to the map for the image.
+    @param y int the row's Y coordinate in the image.
+    @param row unsigned char array holding the row's interleaved RGB samples.
+    @param factors uint32_t array with room for one blend factor per pixel in the row.
+    @param depth int the number of bytes in each sample, 1 or 2.
+    @param border uint16_t array holding the frame's red, green and blue values, already scaled
+                  to the image's maximum intensity.
+    @return void
+*/
+void shadeRow( const WeightMap *map, int y, unsigned char *row, uint32_t *factors, int depth,
+               const uint16_t *border );
+
+#endif
@@ -9,6 +9,9 @@
     The frame's color is determined by a header file called frame.h and the weight of that
     frame's color applied to a pixel will be determined by it's percentage of distance between
     the edge of the frame and the furthest pixel from the center of the image (any corner).
+    Those weights are looked up from a precomputed weight map (see weight.c).
+    Both ASCII (P3) and binary (P6) images are accepted, and the output uses the input's format.
+    Any maximum intensity up to 65535 is accepted, and the frame color is scaled to match it.
 */
 
 
@@ -16,185 +19,306 @@
 #include <stdio.h>
 /** Header file containing standard library functions we will use. */
 #include <stdlib.h>
-/** Header file containing math functions we will use. */
-#include <math.h>
 /** Header file containing string functions we will use. */
 #include <string.h>
+/** Header file containing the getopt() and close() functions we will use. */
+#include <unistd.h>
+/** Header file containing the open() function we will use. */
+#include <fcntl.h>
+/** Header file containing the clock_gettime() function we will use. */
+#include <time.h>
+/** Header file containing the getrusage() function we will use. */
+#include <sys/resource.h>
+/** Header file containing the stat() function we will use. */
+#include <sys/stat.h>
 /** Header file containing the frame's color definition. */
 #include "frame.h"
+/** Header file containing the .ppm reading and writing functions. */
+#include "ppm.h"
+/** Header file containing the weight map functions. */
+#include "weight.h"
+/** Header file containing the blend kernel functions. */
+#include "blend.h"
+/** Header file containing the serial and multi-threaded renderers. */
+#include "render.h"
+/** Header file containing the batch mode function. */
+#include "batch.h"
 
 
 //Global constants.
-/** Constant for exit status when there is a file type error. */
-#define ERRFILE 100
-/** Constant for exit status when there is another header error. */
-#define ERRHEAD 101
-/** Constant for exit status when there is an image error. */
-#define ERRIMG 102
-/** Constant for checking the max intensity. */
-#define WEIGHT 255
-/** Constant for the number of color definitions in a ppm pixel. */
-#define RGBNUM 3
-/** Constant for bisecting the X or Y coordinate plane. */
-#define INHALF 2.0
-/** Constant for the value of one-half pixel distance. */
-#define HALFPIXEL 0.5
-/** Constant for the proper first line of a .ppm file. */
-#define PPM "P3"
-
-//Global variables (constants once known).
-/** Variable for the distance of the X coordinate plane. */
-static int X_PLANE;
-/** Variable for the distance of the Y coordinate plane. */
-static int Y_PLANE;
-/** Variable for the maximum intensity of the input file. */
-static int MAX_INTSTY;
-/** Variable for the maximum distance of a pixel from the center of the input image. */
-static double MAX_DIST;
-/** Variable for the radius of our frame's "window" (inner circle). */
-static double FRAME_RADIUS;
-/** Variable for the X coordinate of the image's center point. */
-static double FRAME_CENTER_X;
-/** Variable for the Y coordinate of the image's center point. */
-static double FRAME_CENTER_Y;
+/** Constant for the exit status when the command line arguments are bad. */
+#define ERRUSAGE 1
 
 
 /**
-    This function is meant to check our input file to ensure it's the correct file type.
-    This is known by whether or not the file begins with "P3."
+    This function prints a usage message to standard error and exits.
 
     @return void
 */
-void checkFileType() {
-    //If the first two chars of input are not p3, it is not a ppm image.
-    char fileType = getchar();
-    if (fileType != 'P') {
-        exit(ERRFILE);
+void usage() {
+    fprintf(stderr, "usage: frame [options] [-t threads] [input-file [output-file]]\n"
+                    "       frame [options] -b list-file\n"
+                    "options: -k scalar|sse2|avx2  -c red,green,blue  -r radius-scale\n"
+                    "         -f linear|quadratic|smoothstep|lut:table-file  -s\n");
+    exit(ERRUSAGE);
+}
+
+/**
+    This function opens a file, or exits with an error message if it can't.
+
+    @param name char pointer to the name of the file.
+    @param mode char pointer to the mode to open it with.
+    @return FILE pointer to the open file.
+*/
+FILE *openFile( const char *name, const char *mode ) {
+    FILE *fp = fopen(name, mode);
+    if (fp == NULL) {
+        fprintf(stderr, "Can't open file: %s\n", name);
+        exit(ERRIO);
     }
-    else {
-        fileType = getchar();
-        if (fileType != '3') {
-            exit(ERRFILE);
-        }
+    setvbuf(fp, NULL, _IOFBF, IOBUFFER);
+    return fp;
+}
+
+/**
+    This function checks if two names are the same file, by device and inode, so another name
+    for the input can't slip past as the output.
+
+    @param inName char pointer to the name of the input file.
+    @param outName char pointer to the name of the output file.
+    @return boolean representing if the output file already exists and is the input file.
+*/
+bool sameFile( const char *inName, const char *outName ) {
+    struct stat inInfo, outInfo;
+    return stat(inName, &inInfo) == 0 && stat(outName, &outInfo) == 0 &&
+           inInfo.st_dev == outInfo.st_dev && inInfo.st_ino == outInfo.st_ino;
+}
+
+/**
+    This function reads the frame color from a "red,green,blue" option, or exits with the usage
+    message if it isn't three intensities from 0 to 255.
+
+    @param arg char pointer to the option's value.
+    @param border unsigned char array the frame's red, green and blue values are stored in.
+    @return void
+*/
+void parseColor( const char *arg, unsigned char *border ) {
+    int red;
+    int green;
+    int blue;
+    char extra;
+    if (sscanf(arg, "%d,%d,%d%c", &red, &green, &blue, &extra) != RGBNUM || red < 0 ||
+            red > WEIGHT || green < 0 || green > WEIGHT || blue < 0 || blue > WEIGHT) {
+        usage();
     }
+    border[0] = red;
+    border[1] = green;
+    border[2] = blue;
 }
 
 /**
-    This function shades the parameterized color by altering its value based on the percentage
-    of distance its pixel is from the edge of the frame.  Towards the edges the pixels in the frame
-    become entirely the frame color, but closer to the window they are mostly their original color
-    with a small percentage of the frame color added.  We accomplish this by altering the RGB
-    values of each color of each pixel according to the R, G, or B value of the border color and
-    the pixel's distance.
-
-    @param color int representing the RGB color that will have weight applied to it.
-    @param borderColor int representing the RGB color of our frame.
-    @param dist double representing the distance from the edge of the frame this pixel is.
+    This function reads the falloff curve from its option, loading the lookup table from a file
+    for a "lut:" curve.  It exits with the usage message if the curve isn't one we know, or
+    with an error message if the table can't be read.
+
+    @param arg char pointer to the option's value.
+    @param table double array FALLOFF_TABLE_SIZE weights are read into for a "lut:" curve.
+    @return FalloffCurve the curve the option names.
+*/
+FalloffCurve parseFalloff( const char *arg, double *table ) {
+    if (strcmp(arg, "linear") == 0) {
+        return FALLOFF_LINEAR;
+    }
+    if (strcmp(arg, "quadratic") == 0) {
+        return FALLOFF_QUADRATIC;
+    }
+    if (strcmp(arg, "smoothstep") == 0) {
+        return FALLOFF_SMOOTHSTEP;
+    }
+    if (strncmp(arg, "lut:", strlen("lut:")) != 0) {
+        usage();
+    }
+
+    const char *name = arg + strlen("lut:");
+    FILE *fp = openFile(name, "r");
+    if (!readFalloffTable(fp, table)) {
+        fprintf(stderr, "Invalid falloff table: %s\n", name);
+        exit(ERRUSAGE);
+    }
+    fclose(fp);
+    return FALLOFF_TABLE;
+}
+
+/**
+    This function prints how fast the images were framed, and how much memory it took, to
+    standard error.
+
+    @param times RenderTimes pointer to the times the renderers added up.
+    @param start struct timespec pointer to when framing started.
     @return void
 */
-void shade( int color, int borderColor, double dist) {
-    //Add weight to each color component of the pixel.  Add frame color times some weight, w plus
-    //the original pixel color times ( 1 - w ).  Round to the nearest int and that will be the new
-    //shaded color for that pixel.
-    double w = (dist - FRAME_RADIUS) / (MAX_DIST - FRAME_RADIUS);
-    int newColor = round(( borderColor * w ) + ( color * ( 1 - w ) ));
-    printf("%3d ", newColor);
+void reportTimes( const RenderTimes *times, const struct timespec *start ) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = end.tv_sec - start->tv_sec + ( end.tv_nsec - start->tv_nsec ) / 1e9;
+    double megapixels = times->pixels / 1e6;
+
+    //Linux reports the peak resident set size in kilobytes.
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(stderr, "frame: %.2f MP in %.3f s, %.2f MP/s (parse %.3f s, shade %.3f s, "
+                    "emit %.3f s), peak RSS %ld KB\n", megapixels, seconds,
+            seconds > 0 ? megapixels / seconds : 0.0, times->parse, times->shade, times->emit,
+            usage.ru_maxrss);
 }
 
 /**
     This is our main function which executes at run.  It will read our user's input, delegate
-    params to our helper functions as needed, and ultimately print the output .ppm file.
+    params to our helper functions as needed, and ultimately print the output .ppm file.  The
+    output is written in the same format (ASCII P3 or binary P6) as the input.  The image comes
+    from standard input and goes to standard output unless file names are given.  The -k option
+    picks which blend kernel to use, otherwise the fastest one the processor supports is used.
+    The -t option frames a binary image with a pool of that many threads (0 for one per
+    processor), which needs both file names; ASCII images always take the serial path.  The -b
+    option frames every input/output pair named in a list file ("-" for standard input).  The
+    -c, -r and -f options replace the frame color from frame.h, scale the window's radius, and
+    pick the curve the frame's weight falls off along.  The -s option reports the throughput,
+    the time spent on each stage and the peak memory use on standard error when it's done.
 
+    @param argc int the number of command line arguments.
+    @param argv char** array holding the command line arguments.
     @return int for the exit status (either failure or success).
 */
-int main() {
-    //Ensure image is of type .PPM.
-    checkFileType();
-
-    //Read the x and y sizes of the image.
-    //If they don't parse as ints or are less than 2, exit with header error.
-    int check;
-    check = scanf("%d %d", &X_PLANE, &Y_PLANE);
-    if (check != 2 || X_PLANE < 2 || Y_PLANE < 2) {
-        exit(ERRHEAD);
-    }
-
-    //Use x and y planes to determine the radius of the frame and its origin
-    //(Remember the frame is drawn from the center to the edge, so in an even shorter plane the
-    //edges of the frame would lay between the furthest pixels, and in an even shorter plane,
-    //the edges of the frame would not touch the furthest pixels.  Thus the -0.5).
-    FRAME_CENTER_X = (X_PLANE / INHALF) - HALFPIXEL;
-    FRAME_CENTER_Y = (Y_PLANE / INHALF) - HALFPIXEL;
-    if ( X_PLANE > Y_PLANE ) {
-        FRAME_RADIUS = FRAME_CENTER_Y;
-    }
-    else {
-        FRAME_RADIUS = FRAME_CENTER_X;
-    }
-
-    //We can use Euclidean distance to find the Maximum Distance, since we know the max
-    //distance is just the distance from the center to any of the corners, such as 0, 0
-    //(Though we won't need absolute values since anthing minus 0 is just that value, so
-    //in this case it's essentially just Pythagoras' theorem).
-    MAX_DIST = sqrt( pow( FRAME_CENTER_Y, 2 ) + pow( FRAME_CENTER_X, 2 ) );
-
-    //Read in the maximum color intensity for the image, exit with error status if it's not 255.
-    scanf("%d", &MAX_INTSTY);
-    if (MAX_INTSTY != WEIGHT) {
-        exit(ERRHEAD);
-    }
-    
-    //Print the PPM identifier, the width and height, and the intensity
-    printf("%s\n", PPM);
-    printf("%d %d\n", X_PLANE, Y_PLANE);
-    printf("%d\n", MAX_INTSTY);
-
-    //Loop through the input and if a pixel lies outside our circle in ANY dimension (center_x
-    //+ radius OR center_y + radius) we will alter its color weight by the % distance it is from
-    //the center to the maximum distance. (The corners will be the 4 maximum distances).  If it
-    //lay within the circle, we will not alter its coloring.
-    for (int y = 0; y < Y_PLANE; y++) {
-        for (int x = 0; x < X_PLANE; x++) {
-            //scan in the pixel's three values (y and x are its coordinates)
-            int red;
-            int green;
-            int blue;
-            int check;
-
-            //Scan in our RGB values from a pixel in the ppm file.
-            check = scanf("%d %d %d", &red, &green, &blue);
-
-            if (check != RGBNUM) {
-                //Body of image error, missing RGB value.
-                exit(ERRIMG);
-            }
+int main( int argc, char **argv ) {
+    //Read the command line options.
+    const char *kernel = NULL;
+    const char *listName = NULL;
+    int threads = -1;
+    bool report = false;
+
+    //The frame color from frame.h, in the order the samples are stored, unless -c replaces it.
+    unsigned char border[RGBNUM] = { FRAME_RED, FRAME_GREEN, FRAME_BLUE };
+    FalloffCurve curve = FALLOFF_LINEAR;
+    double radiusScale = 1.0;
+    double table[FALLOFF_TABLE_SIZE];
 
-            //If this pixel's coords are inside our frame (outside our circle), we will shade them.
-            double distance;
-
-            //Shade weight will be a function of distance, so determine distance from center
-            //determine pixel distance from center using Euclidean metric and cartesian coords
-            //(pow for squaring results.  x and y will represent the x and y coordinate of every
-            //pixel in the image).
-            distance = sqrt((FRAME_CENTER_Y - y ) * (FRAME_CENTER_Y - y) + (FRAME_CENTER_X - x) *
-                                (FRAME_CENTER_X - x));
-
-            //If distance from center > (or equal to?) our circle's radius, pass values to shade.
-            //Otherwise, do not shade the pixel, print it as normal. (call shade 3 times for R, G,
-            //and B values) The border/frame color is given in teh frame.h header file, so we will
-            //use the 3 constants provided there for our borderColor values, depending on the pixel
-            //color we're working with at the time.
-            if (distance > FRAME_RADIUS) {
-                shade(red, FRAME_RED, distance);
-                shade(green, FRAME_GREEN, distance);
-                shade(blue, FRAME_BLUE, distance);
+    int opt;
+    while ((opt = getopt(argc, argv, "k:t:b:c:r:f:s")) != -1) {
+        if (opt == 'k') {
+            kernel = optarg;
+        }
+        else if (opt == 's') {
+            report = true;
+        }
+        else if (opt == 'c') {
+            parseColor(optarg, border);
+        }
+        else if (opt == 'r') {
+            char extra;
+            if (sscanf(optarg, "%lf%c", &radiusScale, &extra) != 1 || !(radiusScale >= 0)) {
+                usage();
             }
-            else {
-                printf("%3d %3d %3d ", red, green, blue);
+        }
+        else if (opt == 'f') {
+            curve = parseFalloff(optarg, table);
+        }
+        else if (opt == 'b') {
+            listName = optarg;
+        }
+        else if (opt == 't') {
+            char extra;
+            if (sscanf(optarg, "%d%c", &threads, &extra) != 1 || threads < 0) {
+                usage();
             }
         }
-        //Print newline for next row of pixels.
-        printf("\n");
+        else {
+            usage();
+        }
+    }
+    if (argc - optind > 2 || (threads >= 0 && argc - optind != 2) ||
+        (listName != NULL && (threads >= 0 || optind != argc))) {
+        usage();
+    }
+
+    //The output can't be the same file as the input, or opening the output would cut the input
+    //out from under the reader or the threads.
+    if (argc - optind == 2 && sameFile(argv[optind], argv[optind + 1])) {
+        usage();
+    }
+    if (!chooseKernel(kernel)) {
+        fprintf(stderr, "Unsupported kernel: %s\n", kernel);
+        exit(ERRUSAGE);
+    }
+    setFalloff(curve, radiusScale, table);
+
+    //Time the whole run, building the weight maps included, if we're asked to report it.
+    RenderTimes times = { 0, 0, 0, 0 };
+    struct timespec start;
+    if (report) {
+        timeRenderers(&times);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
+    //In batch mode every image comes from the list instead.
+    if (listName != NULL) {
+        FILE *list = strcmp(listName, "-") == 0 ? stdin : openFile(listName, "r");
+        int status = renderBatch(list, border);
+        fclose(list);
+        freeWeightMaps();
+        if (report) {
+            reportTimes(&times, &start);
+        }
+        return status;
+    }
+
+    //Give the input a big buffer, since we move whole rows at a time.
+    const char *outName = argc - optind == 2 ? argv[optind + 1] : NULL;
+    int fd = STDIN_FILENO;
+    if (optind < argc) {
+        fd = open(argv[optind], O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "Can't open file: %s\n", argv[optind]);
+            exit(ERRIO);
+        }
+    }
+    Reader in;
+    if (!openReader(&in, fd, IOBUFFER)) {
+        fprintf(stderr, "Out of memory\n");
+        exit(ERRIO);
+    }
+
+    //Ensure image is a .PPM with a valid header, or exit with the error status.
+    PPMHeader header;
+    int status = readHeader(&in, &header);
+    if (status != 0) {
+        exit(status);
+    }
+
+    if (threads >= 0 && header.binary) {
+        status = renderMapped(&in, &header, outName, threads, border);
+    }
+    else {
+        FILE *out = stdout;
+        if (outName != NULL) {
+            out = openFile(outName, "wb");
+        }
+        else {
+            setvbuf(stdout, NULL, _IOFBF, IOBUFFER);
+        }
+        RowBuffers buffers = { NULL, NULL, NULL, 0, 0, 0 };
+        status = renderStream(&in, &header, out, border, &buffers);
+        freeRowBuffers(&buffers);
+        if (fclose(out) != 0 && status == 0) {
+            status = ERRIO;
+        }
+    }
+
+    closeReader(&in);
+    close(fd);
+    freeWeightMaps();
+    if (report) {
+        reportTimes(&times, &start);
     }
-    return 0;
+    return status;
 }
@@ -0,0 +1,126 @@
+/**
+    @file genppm.c
+    @author Scott Spencer (wsspence)
+
+    This program writes a synthetic .ppm image of any size to standard output, for benchmarking
+    frame on images far bigger than the test cases.  The pixels are a smooth color gradient with
+    some noise mixed in, and the same arguments always give the same image.
+*/
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+/** Header file containing the .ppm reading and writing functions. */
+#include "ppm.h"
+
+/** Constant for the exit status when the command line arguments are bad. */
+#define ERRUSAGE 1
+/** Constant for the seed of the noise generator. */
+#define SEED 0x9E3779B97F4A7C15ULL
+/** Constant for how many bits of noise are mixed into each sample, out of 16. */
+#define NOISE_BITS 12
+
+/**
+    This function prints a usage message to standard error and exits.
+
+    @return void
+*/
+void usage() {
+    fprintf(stderr, "usage: genppm width height P3|P6 [max-intensity]\n");
+    exit(ERRUSAGE);
+}
+
+/**
+    This function returns the next number from a xorshift noise generator.
+
+    @param state uint64_t pointer to the generator's state.
+    @return uint64_t the next number.
+*/
+uint64_t nextNoise( uint64_t *state ) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+    This is our main function which executes at run.  It reads the image's size, format and
+    maximum intensity from the command line and writes the image a row at a time.
+
+    @param argc int the number of command line arguments.
+    @param argv char** array holding the command line arguments.
+    @return int for the exit status (either failure or success).
+*/
+int main( int argc, char **argv ) {
+    PPMHeader header;
+    header.maxIntensity = WEIGHT;
+    char extra;
+    if (argc < 4 || argc > 5 || sscanf(argv[1], "%d%c", &header.width, &extra) != 1 ||
+        sscanf(argv[2], "%d%c", &header.height, &extra) != 1 || header.width < 2 ||
+        header.height < 2 || (argc == 5 && sscanf(argv[4], "%d%c", &header.maxIntensity,
+                                                  &extra) != 1)) {
+        usage();
+    }
+    if (strcmp(argv[3], PPM_ASCII) == 0) {
+        header.binary = false;
+    }
+    else if (strcmp(argv[3], PPM_BINARY) == 0) {
+        header.binary = true;
+    }
+    else {
+        usage();
+    }
+    if (header.maxIntensity < 1 || header.maxIntensity > WIDE_WEIGHT) {
+        usage();
+    }
+    header.depth = header.maxIntensity > WEIGHT ? 2 : 1;
+
+    unsigned char *row = malloc(rowSize(&header));
+    char *text = header.binary ? NULL : malloc(rowTextSize(&header));
+    if (row == NULL || (!header.binary && text == NULL)) {
+        fprintf(stderr, "Image is too big\n");
+        exit(ERRIO);
+    }
+    setvbuf(stdout, NULL, _IOFBF, IOBUFFER);
+    writeHeader(stdout, &header);
+
+    uint64_t state = SEED;
+    for (int y = 0; y < header.height; y++) {
+        for (int x = 0; x < header.width; x++) {
+            //Red runs left to right, green top to bottom and blue along the diagonal, each
+            //as a 16 bit level with the top NOISE_BITS of a random number mixed in.
+            uint64_t noise = nextNoise(&state);
+            int levels[RGBNUM] = {
+                (int) (65535LL * x / header.width),
+                (int) (65535LL * y / header.height),
+                (int) (65535LL * (x + y) / (header.width + header.height))
+            };
+            for (int i = 0; i < RGBNUM; i++) {
+                int level = levels[i] / 2 + (int) (noise >> (i * 16) & ((1 << NOISE_BITS) - 1))
+                            * (1 << (15 - NOISE_BITS));
+                int sample = (int) ((int64_t) level * header.maxIntensity / 65535);
+                size_t pos = ((size_t) x * RGBNUM + i) * header.depth;
+                if (header.depth == 1) {
+                    row[pos] = sample;
+                }
+                else {
+                    row[pos] = sample >> 8;
+                    row[pos + 1] = sample;
+                }
+            }
+        }
+        writeRow(stdout, &header, row, text);
+    }
+
+    free(row);
+    free(text);
+    if (fclose(stdout) != 0) {
+        exit(ERRIO);
+    }
+    return EXIT_SUCCESS;
+}
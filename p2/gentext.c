@@ -0,0 +1,208 @@
+/**
+    @file gentext.c
+    @author Scott Spencer (wsspence)
+
+    This program writes a synthetic text corpus of any size to standard output, for benchmarking
+    magic on inputs far bigger than the test cases.  The text is lines of space separated words,
+    some of them numeric literals and some of them identifiers with digits in them, and the
+    share of each and the length of the lines can be picked on the command line.  The same
+    arguments always give the same text.
+*/
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+
+/** Constant for the exit status when the command line arguments are bad. */
+#define ERRUSAGE 1
+/** Constant for the exit status when the text can't be written. */
+#define ERRIO 1
+/** Constant for the seed of the random number generator. */
+#define SEED 0x9E3779B97F4A7C15ULL
+/** Constant for the number of bytes in a megabyte. */
+#define MEGABYTE 1000000
+/** Constant for the size of the buffer the text is built up in before it's written. */
+#define BUFFER ( 1 << 20 )
+/** Constant for the longest word, literal or identifier we write. */
+#define WORD_MAX 32
+/** Constant for the default percentage of words that are numeric literals. */
+#define DIGITS 10
+/** Constant for the default average line length. */
+#define LINE 80
+/** Constant for the default percentage of words that are identifiers with digits in them. */
+#define IDENTIFIERS 20
+
+/**
+    This function prints a usage message to standard error and exits.
+
+    @return void
+*/
+void usage() {
+    fprintf(stderr, "usage: gentext megabytes [digit-percent [line-length "
+                    "[identifier-percent]]]\n");
+    exit(ERRUSAGE);
+}
+
+/**
+    This function returns the next number from a xorshift random number generator.
+
+    @param state uint64_t pointer to the generator's state.
+    @return uint64_t the next number.
+*/
+uint64_t nextRandom( uint64_t *state ) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+    This function writes a random run of chars from a set into a word.
+
+    @param word char array the run is written to.
+    @param count int the number of chars to write.
+    @param set char pointer to the chars to pick from.
+    @param state uint64_t pointer to the generator's state.
+    @return int the number of chars written, which is count.
+*/
+int randomRun( char *word, int count, const char *set, uint64_t *state ) {
+    size_t size = strlen(set);
+    for (int i = 0; i < count; i++) {
+        word[i] = set[nextRandom(state) % size];
+    }
+    return count;
+}
+
+/**
+    This function writes a random numeric literal.  Most are plain decimal numbers, and the rest
+    are spread over the hex, float, suffixed and digit separated forms magic recognizes.
+
+    @param word char array with room for WORD_MAX chars that the literal is written to.
+    @param state uint64_t pointer to the generator's state.
+    @return int the length of the literal.
+*/
+int randomLiteral( char *word, uint64_t *state ) {
+    uint64_t pick = nextRandom(state);
+    int digits = 1 + pick % 6;
+    int len = 0;
+    switch (pick >> 8 & 15) {
+    case 0:
+        word[len++] = '0';
+        word[len++] = 'x';
+        len += randomRun(word + len, digits, "0123456789abcdefABCDEF", state);
+        break;
+    case 1:
+        len = randomRun(word, digits, "0123456789", state);
+        word[len++] = '.';
+        len += randomRun(word + len, 1 + digits % 3, "0123456789", state);
+        word[len++] = 'e';
+        len += randomRun(word + len, 1 + digits % 2, "0123456789", state);
+        break;
+    case 2:
+        len = randomRun(word, digits, "0123456789", state);
+        len += randomRun(word + len, 1 + digits % 2, "uUlL", state);
+        break;
+    case 3:
+        len = randomRun(word, 1, "123456789", state);
+        for (int group = 0; group < 1 + digits % 3; group++) {
+            word[len++] = '\'';
+            len += randomRun(word + len, 3, "0123456789", state);
+        }
+        break;
+    default:
+        len = randomRun(word, digits, "0123456789", state);
+        break;
+    }
+    return len;
+}
+
+/**
+    This is our main function which executes at run.  It reads the corpus's size and mix from
+    the command line and writes the text a buffer at a time.
+
+    @param argc int the number of command line arguments.
+    @param argv char** array holding the command line arguments.
+    @return int for the exit status (either failure or success).
+*/
+int main( int argc, char **argv ) {
+    double megabytes;
+    int digits = DIGITS;
+    int line = LINE;
+    int identifiers = IDENTIFIERS;
+    char extra;
+    if (argc < 2 || argc > 5 || sscanf(argv[1], "%lf%c", &megabytes, &extra) != 1 ||
+        (argc > 2 && sscanf(argv[2], "%d%c", &digits, &extra) != 1) ||
+        (argc > 3 && sscanf(argv[3], "%d%c", &line, &extra) != 1) ||
+        (argc > 4 && sscanf(argv[4], "%d%c", &identifiers, &extra) != 1)) {
+        usage();
+    }
+    if (megabytes <= 0 || digits < 0 || identifiers < 0 || digits + identifiers > 100 ||
+        line < 2) {
+        usage();
+    }
+
+    char *buffer = malloc(BUFFER + WORD_MAX + 1);
+    if (buffer == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(ERRIO);
+    }
+
+    uint64_t state = SEED;
+    size_t total = megabytes * MEGABYTE;
+    size_t written = 0;
+    size_t len = 0;
+    int column = 0;
+    while (written + len < total) {
+        //Pick the kind of word by percentage, then write it.
+        char *word = buffer + len;
+        int kind = nextRandom(&state) % 100;
+        int size = 0;
+        if (kind < digits) {
+            size = randomLiteral(word, &state);
+        }
+        else if (kind < digits + identifiers) {
+            size = randomRun(word, 1 + nextRandom(&state) % 6, "abcdefghijklmnopqrstuvwxyz_",
+                             &state);
+            size += randomRun(word + size, 1 + nextRandom(&state) % 3, "0123456789", &state);
+        }
+        else {
+            size = randomRun(word, 1 + nextRandom(&state) % 9, "abcdefghijklmnopqrstuvwxyz",
+                             &state);
+        }
+
+        //End the line once it's about as long as it should be, and the word otherwise.
+        column += size + 1;
+        if (column >= line) {
+            word[size++] = '\n';
+            column = 0;
+        }
+        else {
+            word[size++] = ' ';
+        }
+        len += size;
+
+        //Write the buffer once it's full or the corpus is done, cut off at exactly the size
+        //asked for.
+        if (len >= BUFFER || written + len >= total) {
+            if (written + len > total) {
+                len = total - written;
+            }
+            if (fwrite(buffer, 1, len, stdout) != len) {
+                exit(ERRIO);
+            }
+            written += len;
+            len = 0;
+        }
+    }
+
+    if (fclose(stdout) != 0) {
+        exit(ERRIO);
+    }
+    free(buffer);
+    return EXIT_SUCCESS;
+}
@@ -3,17 +3,387 @@
     @author Scott Spencer (wsspence)
 
     This program reads the user's input and highlights anything it interprests as a magic number.
+    The input is read and scanned a large block at a time, and everything between the places a
+    highlight starts or stops is copied out as a single run, so the program keeps up with the
+    disk even on very large logs.  Each block is first classified into a bit mask of all its
+    identifier chars, 16 or 32 bytes at a time with SSE2 or AVX2 compares where the processor has
+    them and with the character class table shared with frame otherwise.  Standard input and
+    followed files are read through the shared reader, too.  The places a number or identifier
+    starts or stops are then found by counting zero bits in the mask.  Once a number
+    starts, a table-driven lexer follows it to the end of the C style literal it spells out, so
+    hex and binary numbers, floats with exponents, integer and float suffixes and ' digit
+    separators are all highlighted as one piece.  The highlighted text can come out with ANSI
+    colors, as HTML with every literal in a span, or as just the offset and length of every
+    literal, which doesn't copy the rest of the text at all.  A file named on the command line is
+    memory-mapped instead, split into chunks, and highlighted by a pool of threads, with each
+    chunk's output written out in order.  A file can also be followed as it grows, like tail -f
+    does, with each append highlighted as it comes in.  For C, shell or Python source, comments
+    and strings can be recognized and skipped over, so the numbers in them are left plain.
+    Instead of highlighting, the program can count every literal across any number of files and
+    report which ones recur most, since those are the ones most worth giving a name.
  */
 
 /** Header file for standard input/output functions we will use */
 #include <stdio.h>
 /** Header file for the standard boolean data type */
 #include <stdbool.h>
+/** Header file for the UCHAR_MAX limit */
+#include <limits.h>
+/** Header file for fixed width integer types */
+#include <stdint.h>
+/** Header file for the memcpy(), memmove(), strchr() and strcmp() functions */
+#include <string.h>
+/** Header file for the exit() function */
+#include <stdlib.h>
+/** Header file for the getopt(), close() and sysconf() functions */
+#include <unistd.h>
+/** Header file for the errno variable */
+#include <errno.h>
+/** Header file for the POSIX thread functions */
+#include <pthread.h>
+/** Header file for the open() function and its flags */
+#include <fcntl.h>
+/** Header file for the memory mapping functions */
+#include <sys/mman.h>
+/** Header file for the fstat() function */
+#include <sys/stat.h>
+/** Header file for the poll() function */
+#include <poll.h>
+/** Header file for the clock_gettime() and nanosleep() functions */
+#include <time.h>
+/** Header file for the getrusage() function */
+#include <sys/resource.h>
+/** Header file for the reader and character classes shared with frame */
+#include "scan.h"
+
+//Followed files are watched with inotify where there is one, and polled otherwise.
+#ifdef __linux__
+/** Defined when followed files are watched with inotify */
+#define MAGIC_INOTIFY
+/** Header file for the inotify functions */
+#include <sys/inotify.h>
+#endif
+
+//The SIMD classifiers need GCC style target attributes and an x86 processor.
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+/** Defined when the SSE2 and AVX2 classifiers are compiled in */
+#define MAGIC_X86
+/** Header file for the SSE2 and AVX2 intrinsics we will use */
+#include <immintrin.h>
+#endif
 
 /** Constant sequence of chars representing the color RED */
 #define RED "\033[31m" //(033 is octal representation of ascii decimal 27)
 /** Constant sequence of chars representing the default color */
 #define RESET "\033[0m"
+/** Constant sequence of chars starting an HTML highlight */
+#define SPAN "<span class=\"magic\">"
+/** Constant sequence of chars ending an HTML highlight */
+#define END_SPAN "</span>"
+/** Constant for the most digits a size_t can have in decimal */
+#define SIZE_DIGITS 20
+/** Constant for the number of bytes read and scanned at a time */
+#define BLOCK ( 1 << 16 )
+/** Constant for the size of the output buffer */
+#define OUTBUFFER ( 1 << 20 )
+/** Constant for the exit status when the command line arguments are bad */
+#define ERRUSAGE 1
+/** Constant for the exit status when the input file can't be opened or mapped */
+#define ERRIO 1
+/** Constant for about how many bytes of a mapped file go in each chunk */
+#define CHUNK ( 1 << 22 )
+/** Constant for how many chunks past the last one written the threads may get ahead */
+#define AHEAD 4
+/** Constant for the number of bytes each word of the token mask covers */
+#define MASK_BITS 64
+/** Constant for the most milliseconds highlighted text waits to be written while following */
+#define LATENCY 100
+/** Constant for how many milliseconds a followed file goes between checks for more text */
+#define POLL 250
+/** Constant for the number of nanoseconds in a millisecond */
+#define NS_PER_MS 1000000
+/** Constant for how many of the places a literal was found the statistics keep */
+#define LOCATIONS 3
+/** Constant for the number of slots a table of literals starts with, a power of 2 */
+#define TABLE_START 1024
+/** Constant for the FNV-1a hash's starting value */
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+/** Constant for the FNV-1a hash's multiplier */
+#define FNV_PRIME 0x100000001b3ULL
+
+/** Classes of bytes, as far as the literal lexer is concerned.  Every class from L_ZERO to
+    L_LETTER can be part of an identifier, and the classes from L_ZERO to L_F are hex digits. */
+enum {
+    /** Can't be part of a literal or an identifier */
+    L_OTHER,
+    L_ZERO,
+    L_ONE,
+    /** 2 to 7 */
+    L_OCTAL,
+    /** 8 and 9 */
+    L_DECIMAL,
+    /** Hex digits with no other meaning: a, c and d in either case */
+    L_HEX,
+    /** b or B, a hex digit or the binary prefix */
+    L_B,
+    /** e or E, a hex digit or the exponent */
+    L_E,
+    /** f or F, a hex digit or the float suffix */
+    L_F,
+    /** x or X, the hex prefix */
+    L_X,
+    /** p or P, the exponent of a hex float */
+    L_P,
+    /** u or U, the unsigned suffix */
+    L_U,
+    /** l or L, the long suffix */
+    L_L,
+    /** z or Z, the size suffix */
+    L_Z,
+    /** Any other letter, or an underscore */
+    L_LETTER,
+    L_DOT,
+    /** + or -, the sign of an exponent */
+    L_SIGN,
+    /** ', the digit separator */
+    L_QUOTE,
+    /** Number of byte classes */
+    L_CLASSES
+};
+
+/** States of the literal lexer.  A literal can end right after an accepting state, and it can
+    end after a suffix as long as the next byte isn't part of an identifier. */
+enum {
+    /** Before the first digit */
+    LIT_START,
+    /** A lone 0 (accepting) */
+    LIT_ZERO,
+    /** Decimal or octal digits (accepting) */
+    LIT_DECIMAL,
+    /** A digit separator between decimal digits */
+    LIT_DECIMAL_QUOTE,
+    /** A decimal point, which only counts when a digit, an exponent or a suffix follows it */
+    LIT_DOT,
+    /** Digits after the decimal point (accepting) */
+    LIT_FRACTION,
+    /** A digit separator between fraction digits */
+    LIT_FRACTION_QUOTE,
+    /** e or E */
+    LIT_EXPONENT,
+    /** The sign of an exponent */
+    LIT_EXPONENT_SIGN,
+    /** Digits of an exponent (accepting) */
+    LIT_EXPONENT_DIGITS,
+    /** 0x or 0X */
+    LIT_HEX_PREFIX,
+    /** Hex digits (accepting) */
+    LIT_HEX,
+    /** A digit separator between hex digits */
+    LIT_HEX_QUOTE,
+    /** The point and fraction of a hex float, which needs an exponent */
+    LIT_HEX_FRACTION,
+    /** p or P */
+    LIT_BINARY_EXPONENT,
+    /** The sign of a hex float's exponent */
+    LIT_BINARY_EXPONENT_SIGN,
+    /** Digits of a hex float's exponent (accepting) */
+    LIT_BINARY_EXPONENT_DIGITS,
+    /** 0b or 0B */
+    LIT_BINARY_PREFIX,
+    /** Binary digits (accepting) */
+    LIT_BINARY,
+    /** A digit separator between binary digits */
+    LIT_BINARY_QUOTE,
+    /** Suffix u */
+    LIT_SUFFIX_U,
+    /** Suffix ul */
+    LIT_SUFFIX_UL,
+    /** Suffix l */
+    LIT_SUFFIX_L,
+    /** Suffix ll */
+    LIT_SUFFIX_LL,
+    /** Suffix z */
+    LIT_SUFFIX_Z,
+    /** A suffix that can't go on any further */
+    LIT_SUFFIX_DONE,
+    /** Number of lexer states */
+    LIT_STATES,
+    /** Not a state: the literal ends just before this byte */
+    LIT_ACCEPT = LIT_STATES,
+    /** Not a state: the literal ends right after the last accepting state */
+    LIT_REJECT
+};
+
+/** States the scanner can be in between two bytes, and so between two blocks */
+typedef enum {
+    /** Not inside a number or an identifier */
+    START,
+    /** Inside an identifier, whose digits are never highlighted */
+    IDENTIFIER,
+    /** Inside a highlighted number */
+    NUMBER,
+    /** Inside a comment that runs to the end of the line */
+    LINE_COMMENT,
+    /** Inside a C comment, which runs to the next star and slash */
+    BLOCK_COMMENT,
+    /** Inside a string or char literal */
+    STRING
+} ScanState;
+
+/** Languages whose comments and strings the scanner knows how to skip */
+typedef enum {
+    /** Plain text, with no comments or strings */
+    PLAIN,
+    /** C and C++, with both kinds of comment and backslash escapes in strings */
+    C_SOURCE,
+    /** Shell scripts, with # comments and single quoted strings that have no escapes */
+    SHELL,
+    /** Python, with # comments and triple quoted strings */
+    PYTHON
+} Language;
+
+/** Structure holding where the scanner is between two blocks */
+typedef struct {
+    /** State of the scanner */
+    ScanState state;
+    /** State of the literal lexer, when the scanner is inside a number */
+    int literal;
+    /** Offset in the input of the current literal's first byte */
+    size_t start;
+    /** Offset in the input of the next block's first byte */
+    size_t base;
+    /** The quote that ends the current string */
+    unsigned char quote;
+    /** True if the current string is ended by three quotes in a row */
+    bool triple;
+    /** True if backslashes escape the next char in the current string */
+    bool escapes;
+    /** The byte just before the next block, a newline at the start of the input */
+    unsigned char before;
+} Scan;
+
+/** Type for a pointer to one of the classifiers */
+typedef void (*Classifier)( const unsigned char *block, size_t size, uint64_t *tokens );
+
+/** Lookup table giving the literal lexer's class of every byte, filled in by buildLiterals() */
+static unsigned char literalClasses[ UCHAR_MAX + 1 ];
+
+/** The literal lexer's next state for every state and byte class, filled in by buildLiterals() */
+static unsigned char literalNext[ LIT_STATES ][ L_CLASSES ];
+
+/** True for every accepting state of the literal lexer */
+static bool literalAccepts[ LIT_STATES ];
+
+/** Number of input bytes that have been scanned, for the -r report */
+static size_t scanned = 0;
+
+/** The language highlightBlock() skips the comments and strings of, PLAIN until
+    chooseLanguage() is called */
+static Language language = PLAIN;
+
+/** Lookup table that's true for every byte that might start a comment or string in the
+    language, filled in by chooseLanguage() */
+static bool openers[ UCHAR_MAX + 1 ];
+
+/** Structure holding one place a literal was found */
+typedef struct {
+    /** Index of the file in the list of files */
+    int file;
+    /** Offset of the literal's first byte in the file */
+    size_t offset;
+    /** Line the literal is on, counting from 1 */
+    size_t line;
+} Location;
+
+/** Structure holding everything the statistics know about one literal */
+typedef struct {
+    /** The literal's text, or NULL for an empty slot of a table */
+    char *text;
+    /** Number of chars in the text */
+    size_t len;
+    /** Hash of the text */
+    uint64_t hash;
+    /** Number of times the literal was found */
+    size_t count;
+    /** Number of locations kept */
+    int found;
+    /** The first places the literal was found, in order */
+    Location first[ LOCATIONS ];
+} Literal;
+
+/** Structure holding a hash table of literals, with linear probing */
+typedef struct {
+    /** The table's slots */
+    Literal *slots;
+    /** Number of slots, a power of 2 */
+    size_t capacity;
+    /** Number of slots in use */
+    size_t count;
+    /** Index of the file literals are being counted from */
+    int file;
+    /** Offset in the file that newlines have been counted up to */
+    size_t counted;
+    /** Line of the file that offset is on, counting from 1 */
+    size_t line;
+} Table;
+
+/** Structure holding highlighted text that's waiting to be written */
+typedef struct {
+    /** The text */
+    char *text;
+    /** Number of chars in the text */
+    size_t len;
+    /** Number of chars text has room for */
+    size_t capacity;
+    /** True if text grows to hold everything, false if it's written out whenever it's full */
+    bool grow;
+    /** The whole input, when it's all in memory, so a literal's text can be looked up */
+    const unsigned char *input;
+    /** Table the statistics backend counts literals in */
+    Table *table;
+} Output;
+
+/** Structure holding the functions of an output backend */
+typedef struct {
+    /** Name of the backend, for the -o option */
+    const char *name;
+    /** Adds a run of input text to the output, whether it's highlighted or not */
+    void (*text)( Output *out, const unsigned char *text, size_t len );
+    /** Starts highlighting a literal, given the offset of its first byte */
+    void (*open)( Output *out, size_t start );
+    /** Stops highlighting a literal, given the offsets of its first byte and just past its last */
+    void (*close)( Output *out, size_t start, size_t end );
+} Backend;
+
+/** Structure holding one chunk of a mapped file and its highlighted text */
+typedef struct {
+    /** Index of the chunk's first byte */
+    size_t start;
+    /** Index just past the chunk's last byte */
+    size_t end;
+    /** The chunk's highlighted text */
+    Output out;
+    /** True once out holds the whole chunk */
+    bool done;
+} Chunk;
+
+/** Structure holding everything the threads share while highlighting a mapped file */
+typedef struct {
+    /** Contents of the file */
+    const unsigned char *data;
+    /** The file's chunks, in order */
+    Chunk *chunks;
+    /** Number of chunks */
+    size_t count;
+    /** The next chunk that hasn't been handed to a thread yet */
+    size_t next;
+    /** Number of chunks that have been written out */
+    size_t written;
+    /** Lock protecting next, written and every chunk's done flag */
+    pthread_mutex_t lock;
+    /** Signaled whenever a chunk is done or written */
+    pthread_cond_t changed;
+} MagicJob;
 
 /**
     This function takes a char data type and returns a boolean representing whether or not that
@@ -49,90 +419,1857 @@ bool isAlpha( char ch ) {
 }
 
 /**
-    This function prints the character on the stream to output highlighted red, as well as any
-    digits that follow that char, then changes the printing color back to the default.
+    This function sets the literal lexer's next state for a range of byte classes.
+
+    @param state int the state to move from.
+    @param first int the first class of the range.
+    @param last int the last class of the range.
+    @param next int the state to move to.
+    @return void
+*/
+static void addMoves( int state, int first, int last, int next ) {
+    for ( int c = first; c <= last; c++ ) {
+        literalNext[ state ][ c ] = next;
+    }
+}
+
+/**
+    This function adds the moves from a state that has just finished the digits of an integer
+    into its suffixes.
+
+    @param state int the state to move from.
+    @return void
+*/
+static void addIntegerSuffixes( int state ) {
+    addMoves( state, L_U, L_U, LIT_SUFFIX_U );
+    addMoves( state, L_L, L_L, LIT_SUFFIX_L );
+    addMoves( state, L_Z, L_Z, LIT_SUFFIX_Z );
+}
+
+/**
+    This function fills in the literal lexer's tables.  The lexer follows the C and C++ rules
+    for integer and floating literals, except that a decimal point only counts when a digit, an
+    exponent or a float suffix follows it, so a number at the end of a sentence doesn't take the
+    period with it.  A float that starts with its decimal point, like .5, is started by the
+    scanner in the LIT_DOT state.  Every
+    move not listed here rejects, ending the literal at its last accepting state, and a suffix
+    accepts on any byte that can't be part of an identifier.
 
     @return void
 */
-void highlightNumber() {
-    //If token is an integer, highlight it.
-    char ch = getchar();
+void buildLiterals() {
+    for ( int ch = 0; ch <= UCHAR_MAX; ch++ ) {
+        int lower = ch | 0x20;
+        if ( ch == '0' ) {
+            literalClasses[ ch ] = L_ZERO;
+        }
+        else if ( ch == '1' ) {
+            literalClasses[ ch ] = L_ONE;
+        }
+        else if ( ch >= '2' && ch <= '7' ) {
+            literalClasses[ ch ] = L_OCTAL;
+        }
+        else if ( isDigit( ch ) ) {
+            literalClasses[ ch ] = L_DECIMAL;
+        }
+        else if ( isAlpha( ch ) ) {
+            const char *letters = "acdbefxpulz";
+            const unsigned char classes[] = { L_HEX, L_HEX, L_HEX, L_B, L_E, L_F, L_X, L_P, L_U,
+                                              L_L, L_Z };
+            const char *found = strchr( letters, lower );
+            literalClasses[ ch ] = found != NULL ? classes[ found - letters ] : L_LETTER;
+        }
+        else if ( ch == '_' ) {
+            literalClasses[ ch ] = L_LETTER;
+        }
+        else if ( ch == '.' ) {
+            literalClasses[ ch ] = L_DOT;
+        }
+        else if ( ch == '+' || ch == '-' ) {
+            literalClasses[ ch ] = L_SIGN;
+        }
+        else if ( ch == '\'' ) {
+            literalClasses[ ch ] = L_QUOTE;
+        }
+        else {
+            literalClasses[ ch ] = L_OTHER;
+        }
+    }
+
+    for ( int state = 0; state < LIT_STATES; state++ ) {
+        addMoves( state, 0, L_CLASSES - 1, LIT_REJECT );
+        literalAccepts[ state ] = false;
+    }
+
+    addMoves( LIT_START, L_ZERO, L_ZERO, LIT_ZERO );
+    addMoves( LIT_START, L_ONE, L_DECIMAL, LIT_DECIMAL );
+
+    //Decimal and octal integers, and the start of hex and binary ones.
+    addMoves( LIT_ZERO, L_ZERO, L_DECIMAL, LIT_DECIMAL );
+    addMoves( LIT_ZERO, L_X, L_X, LIT_HEX_PREFIX );
+    addMoves( LIT_ZERO, L_B, L_B, LIT_BINARY_PREFIX );
+    addMoves( LIT_DECIMAL, L_ZERO, L_DECIMAL, LIT_DECIMAL );
+    addMoves( LIT_DECIMAL_QUOTE, L_ZERO, L_DECIMAL, LIT_DECIMAL );
+    for ( int state = LIT_ZERO; state <= LIT_DECIMAL; state++ ) {
+        addMoves( state, L_QUOTE, L_QUOTE, LIT_DECIMAL_QUOTE );
+        addMoves( state, L_DOT, L_DOT, LIT_DOT );
+        addMoves( state, L_E, L_E, LIT_EXPONENT );
+        addIntegerSuffixes( state );
+    }
 
-    //Change print color to red.
-    printf( RED );
+    //Decimal floats.
+    addMoves( LIT_DOT, L_ZERO, L_DECIMAL, LIT_FRACTION );
+    addMoves( LIT_DOT, L_E, L_E, LIT_EXPONENT );
+    addMoves( LIT_FRACTION, L_ZERO, L_DECIMAL, LIT_FRACTION );
+    addMoves( LIT_FRACTION, L_QUOTE, L_QUOTE, LIT_FRACTION_QUOTE );
+    addMoves( LIT_FRACTION, L_E, L_E, LIT_EXPONENT );
+    addMoves( LIT_FRACTION_QUOTE, L_ZERO, L_DECIMAL, LIT_FRACTION );
+    addMoves( LIT_EXPONENT, L_SIGN, L_SIGN, LIT_EXPONENT_SIGN );
+    addMoves( LIT_EXPONENT, L_ZERO, L_DECIMAL, LIT_EXPONENT_DIGITS );
+    addMoves( LIT_EXPONENT_SIGN, L_ZERO, L_DECIMAL, LIT_EXPONENT_DIGITS );
+    addMoves( LIT_EXPONENT_DIGITS, L_ZERO, L_DECIMAL, LIT_EXPONENT_DIGITS );
 
-    //Print the digit (since it's back on the stream).
-    while ( isDigit( ch ) ) {
-        printf( "%c", ch );
-        ch = getchar();
+    //Hex integers and floats.
+    addMoves( LIT_HEX_PREFIX, L_ZERO, L_F, LIT_HEX );
+    addMoves( LIT_HEX, L_ZERO, L_F, LIT_HEX );
+    addMoves( LIT_HEX, L_QUOTE, L_QUOTE, LIT_HEX_QUOTE );
+    addMoves( LIT_HEX, L_DOT, L_DOT, LIT_HEX_FRACTION );
+    addMoves( LIT_HEX, L_P, L_P, LIT_BINARY_EXPONENT );
+    addIntegerSuffixes( LIT_HEX );
+    addMoves( LIT_HEX_QUOTE, L_ZERO, L_F, LIT_HEX );
+    addMoves( LIT_HEX_FRACTION, L_ZERO, L_F, LIT_HEX_FRACTION );
+    addMoves( LIT_HEX_FRACTION, L_P, L_P, LIT_BINARY_EXPONENT );
+    addMoves( LIT_BINARY_EXPONENT, L_SIGN, L_SIGN, LIT_BINARY_EXPONENT_SIGN );
+    addMoves( LIT_BINARY_EXPONENT, L_ZERO, L_DECIMAL, LIT_BINARY_EXPONENT_DIGITS );
+    addMoves( LIT_BINARY_EXPONENT_SIGN, L_ZERO, L_DECIMAL, LIT_BINARY_EXPONENT_DIGITS );
+    addMoves( LIT_BINARY_EXPONENT_DIGITS, L_ZERO, L_DECIMAL, LIT_BINARY_EXPONENT_DIGITS );
+
+    //Binary integers.
+    addMoves( LIT_BINARY_PREFIX, L_ZERO, L_ONE, LIT_BINARY );
+    addMoves( LIT_BINARY, L_ZERO, L_ONE, LIT_BINARY );
+    addMoves( LIT_BINARY, L_QUOTE, L_QUOTE, LIT_BINARY_QUOTE );
+    addIntegerSuffixes( LIT_BINARY );
+    addMoves( LIT_BINARY_QUOTE, L_ZERO, L_ONE, LIT_BINARY );
+
+    //Float suffixes.
+    addMoves( LIT_FRACTION, L_F, L_F, LIT_SUFFIX_DONE );
+    addMoves( LIT_FRACTION, L_L, L_L, LIT_SUFFIX_DONE );
+    addMoves( LIT_DOT, L_F, L_F, LIT_SUFFIX_DONE );
+    addMoves( LIT_DOT, L_L, L_L, LIT_SUFFIX_DONE );
+    addMoves( LIT_EXPONENT_DIGITS, L_F, L_F, LIT_SUFFIX_DONE );
+    addMoves( LIT_EXPONENT_DIGITS, L_L, L_L, LIT_SUFFIX_DONE );
+    addMoves( LIT_BINARY_EXPONENT_DIGITS, L_F, L_F, LIT_SUFFIX_DONE );
+    addMoves( LIT_BINARY_EXPONENT_DIGITS, L_L, L_L, LIT_SUFFIX_DONE );
+
+    //Integer suffixes: u, l, ll or z, with a u before or after any of the others.
+    for ( int state = LIT_SUFFIX_U; state <= LIT_SUFFIX_DONE; state++ ) {
+        addMoves( state, L_OTHER, L_OTHER, LIT_ACCEPT );
+        addMoves( state, L_DOT, L_QUOTE, LIT_ACCEPT );
     }
-    //Change color back to default.
-    printf( RESET );
+    addMoves( LIT_SUFFIX_U, L_L, L_L, LIT_SUFFIX_UL );
+    addMoves( LIT_SUFFIX_U, L_Z, L_Z, LIT_SUFFIX_DONE );
+    addMoves( LIT_SUFFIX_UL, L_L, L_L, LIT_SUFFIX_DONE );
+    addMoves( LIT_SUFFIX_L, L_L, L_L, LIT_SUFFIX_LL );
+    addMoves( LIT_SUFFIX_L, L_U, L_U, LIT_SUFFIX_DONE );
+    addMoves( LIT_SUFFIX_LL, L_U, L_U, LIT_SUFFIX_DONE );
+    addMoves( LIT_SUFFIX_Z, L_U, L_U, LIT_SUFFIX_DONE );
 
-    //Print the next char (if it's not an EOF).
-    if ( ch != EOF ) {
-        printf( "%c", ch );
+    int accepting[] = { LIT_ZERO, LIT_DECIMAL, LIT_FRACTION, LIT_EXPONENT_DIGITS, LIT_HEX,
+                        LIT_BINARY_EXPONENT_DIGITS, LIT_BINARY };
+    for ( size_t i = 0; i < sizeof( accepting ) / sizeof( accepting[ 0 ] ); i++ ) {
+        literalAccepts[ accepting[ i ] ] = true;
     }
 }
 
 /**
-    This function prints the char on the stream to output in the default color, as well as
-    any chars that follow it (as long as they are numeric digits, alphabetical letters, or
-    underscores.
+    This function is the plain C classifier, which looks every byte up in the table of character
+    classes.  It's also used for the last few bytes of a block that don't fill a whole SIMD
+    register.  Bit n of each mask word is byte n of the word's 64 byte stretch of the block.
 
+    @param block unsigned char array holding the block's bytes.
+    @param size size_t the number of bytes in the block.
+    @param tokens uint64_t array the token mask is stored in, with a bit set for each digit,
+                  letter and underscore.
     @return void
 */
-void skipIdentifier() {
-    //If token is identifier, skip highlighting any digits in this token (move stream to
-    //next char after token).
-    char ch = getchar();
+static void classifyScalar( const unsigned char *block, size_t size, uint64_t *tokens ) {
+    for ( size_t w = 0; w * MASK_BITS < size; w++ ) {
+        const unsigned char *stretch = block + w * MASK_BITS;
+        size_t count = size - w * MASK_BITS < MASK_BITS ? size - w * MASK_BITS : MASK_BITS;
+        uint64_t token = 0;
+        for ( size_t j = 0; j < count; j++ ) {
+            token |= ( uint64_t ) ( ( charClasses[ stretch[ j ] ] & CHAR_TOKEN ) != 0 ) << j;
+        }
+        tokens[ w ] = token;
+    }
+}
+
+#ifdef MAGIC_X86
+
+/**
+    This function is the SSE2 classifier, which does 16 bytes at a time.  Signed compares leave
+    every byte over 127 out of the digit and letter ranges, and setting the 0x20 bit folds upper
+    case letters onto lower case ones.
 
-    //Loop, printing the chars of the token, until the end of the token
-    //(excluding tabs since Jenkins tells me that's wrong).
-    while ( isAlpha( ch ) || isDigit( ch ) || ch == '_' ) {
-        printf( "%c", ch );
-        ch = getchar();
+    @param block unsigned char array holding the block's bytes.
+    @param size size_t the number of bytes in the block.
+    @param tokens uint64_t array the token mask is stored in, with a bit set for each digit,
+                  letter and underscore.
+    @return void
+*/
+__attribute__(( target( "sse2" ) ))
+static void classifySSE2( const unsigned char *block, size_t size, uint64_t *tokens ) {
+    size_t w = 0;
+    for ( ; ( w + 1 ) * MASK_BITS <= size; w++ ) {
+        uint64_t token = 0;
+        for ( int j = 0; j < MASK_BITS; j += 16 ) {
+            __m128i bytes = _mm_loadu_si128( ( const __m128i * ) ( block + w * MASK_BITS + j ) );
+            __m128i lower = _mm_or_si128( bytes, _mm_set1_epi8( 0x20 ) );
+            __m128i isDigit = _mm_and_si128( _mm_cmpgt_epi8( bytes, _mm_set1_epi8( '0' - 1 ) ),
+                                             _mm_cmplt_epi8( bytes, _mm_set1_epi8( '9' + 1 ) ) );
+            __m128i isLetter = _mm_and_si128( _mm_cmpgt_epi8( lower, _mm_set1_epi8( 'a' - 1 ) ),
+                                              _mm_cmplt_epi8( lower, _mm_set1_epi8( 'z' + 1 ) ) );
+            __m128i isToken = _mm_or_si128( _mm_or_si128( isDigit, isLetter ),
+                                            _mm_cmpeq_epi8( bytes, _mm_set1_epi8( '_' ) ) );
+            token |= ( uint64_t ) _mm_movemask_epi8( isToken ) << j;
+        }
+        tokens[ w ] = token;
     }
+    classifyScalar( block + w * MASK_BITS, size - w * MASK_BITS, tokens + w );
+}
+
+/**
+    This function is the AVX2 classifier, which does 32 bytes at a time the same way
+    classifySSE2() does.
 
-    //Print the next char (if it's not an EOF).
-    if ( ch != EOF ) {
-        printf( "%c", ch );
+    @param block unsigned char array holding the block's bytes.
+    @param size size_t the number of bytes in the block.
+    @param tokens uint64_t array the token mask is stored in, with a bit set for each digit,
+                  letter and underscore.
+    @return void
+*/
+__attribute__(( target( "avx2" ) ))
+static void classifyAVX2( const unsigned char *block, size_t size, uint64_t *tokens ) {
+    size_t w = 0;
+    for ( ; ( w + 1 ) * MASK_BITS <= size; w++ ) {
+        uint64_t token = 0;
+        for ( int j = 0; j < MASK_BITS; j += 32 ) {
+            __m256i bytes = _mm256_loadu_si256( ( const __m256i * ) ( block + w * MASK_BITS +
+                                                                      j ) );
+            __m256i lower = _mm256_or_si256( bytes, _mm256_set1_epi8( 0x20 ) );
+            __m256i isDigit = _mm256_andnot_si256( _mm256_cmpgt_epi8( _mm256_set1_epi8( '0' ),
+                                                                      bytes ),
+                                                   _mm256_cmpgt_epi8( _mm256_set1_epi8( '9' + 1 ),
+                                                                      bytes ) );
+            __m256i isLetter = _mm256_andnot_si256( _mm256_cmpgt_epi8( _mm256_set1_epi8( 'a' ),
+                                                                       lower ),
+                                                    _mm256_cmpgt_epi8( _mm256_set1_epi8( 'z' + 1 ),
+                                                                       lower ) );
+            __m256i isToken = _mm256_or_si256( _mm256_or_si256( isDigit, isLetter ),
+                                               _mm256_cmpeq_epi8( bytes,
+                                                                  _mm256_set1_epi8( '_' ) ) );
+            token |= ( uint64_t ) ( uint32_t ) _mm256_movemask_epi8( isToken ) << j;
+        }
+        tokens[ w ] = token;
     }
+    classifyScalar( block + w * MASK_BITS, size - w * MASK_BITS, tokens + w );
 }
 
+#endif
+
+/** The classifier highlightBlock() uses, the plain C one until chooseClassifier() is called */
+static Classifier classifier = classifyScalar;
+
 /**
-    This is our main function which runs the program, reading in the users input and delegating
-    tasks to our helper functions based on that input.
+    This function picks the classifier highlightBlock() will use.
 
-    @return int representing exit success
+    @param want char pointer to "scalar", "sse2" or "avx2", or NULL for the fastest classifier
+                the processor supports.
+    @return boolean representing if there's a classifier by that name the processor can run
 */
-int main() {
-    char ch;
+bool chooseClassifier( const char *want ) {
+#ifdef MAGIC_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports( "avx2" );
+    bool sse2 = __builtin_cpu_supports( "sse2" );
+#else
+    bool avx2 = false;
+    bool sse2 = false;
+#endif
+
+    //With no name given, take the fastest classifier we can run.
+    if ( want == NULL ) {
+        want = avx2 ? "avx2" : sse2 ? "sse2" : "scalar";
+    }
+
+    if ( strcmp( want, "scalar" ) == 0 ) {
+        classifier = classifyScalar;
+    }
+#ifdef MAGIC_X86
+    else if ( strcmp( want, "sse2" ) == 0 && sse2 ) {
+        classifier = classifySSE2;
+    }
+    else if ( strcmp( want, "avx2" ) == 0 && avx2 ) {
+        classifier = classifyAVX2;
+    }
+#endif
+    else {
+        return false;
+    }
+    return true;
+}
+
+/**
+    This function finds the first byte at or after an index whose bit in the token mask is set (or
+    clear).  Bits past the end of the block are clear, so a search for a clear bit stops at the
+    end of the block.
 
-    //Read user input one char at a time.
-    ch = getchar();
-    while ( ch != EOF ) {
-        //Check if ch is the beginning of an identifier (letter or underscore).
-        if ( isAlpha( ch ) || ch == '_' ) {
-            //iterate through token
-            ungetc( ch, stdin );
-            skipIdentifier();
+    @param mask uint64_t array holding the block's token mask.
+    @param i size_t the index to start looking at.
+    @param size size_t the number of bytes in the block.
+    @param set boolean representing if we're looking for a set bit instead of a clear one.
+    @return size_t the index of the first byte found, or size if there isn't one.
+*/
+static inline size_t findBit( const uint64_t *mask, size_t i, size_t size, bool set ) {
+    uint64_t flip = set ? 0 : ~( uint64_t ) 0;
+    size_t w = i / MASK_BITS;
+    uint64_t bits = ( mask[ w ] ^ flip ) & ( ~( uint64_t ) 0 << ( i % MASK_BITS ) );
+    while ( bits == 0 ) {
+        w++;
+        if ( w * MASK_BITS >= size ) {
+            return size;
         }
+        bits = mask[ w ] ^ flip;
+    }
+    size_t found = w * MASK_BITS + __builtin_ctzll( bits );
+    return found < size ? found : size;
+}
 
-        //Check if ch is a digit (that isn't part of an identifier).
-        else if ( isDigit( ch ) ) {
-            //Put ch back on stream to be read again, then highlight it.
-            ungetc( ch, stdin );
-            highlightNumber();
+/**
+    This function writes out everything waiting in an output buffer.
+
+    @param out Output pointer to the buffer.
+    @return void
+*/
+void flushOutput( Output *out ) {
+    if ( out->len > 0 ) {
+        fwrite( out->text, 1, out->len, stdout );
+    }
+    out->len = 0;
+}
+
+/**
+    This function adds a run of chars to an output buffer.  A growing buffer is made bigger if
+    the run doesn't fit, otherwise the buffer is written out first, and runs bigger than the
+    whole buffer are written straight out.
+
+    @param out Output pointer to the buffer.
+    @param text pointer to the chars to add.
+    @param len size_t the number of chars to add.
+    @return void
+*/
+void emit( Output *out, const void *text, size_t len ) {
+    if ( len == 0 ) {
+        return;
+    }
+    if ( out->len + len > out->capacity ) {
+        if ( out->grow ) {
+            size_t capacity = out->capacity * 2 > out->len + len ? out->capacity * 2
+                                                                 : out->len + len;
+            char *bigger = realloc( out->text, capacity );
+            if ( bigger == NULL ) {
+                fprintf( stderr, "Out of memory\n" );
+                exit( ERRIO );
+            }
+            out->text = bigger;
+            out->capacity = capacity;
+        }
+        else {
+            flushOutput( out );
+            if ( len > out->capacity ) {
+                fwrite( text, 1, len, stdout );
+                return;
+            }
+        }
+    }
+    memcpy( out->text + out->len, text, len );
+    out->len += len;
+}
+
+/**
+    This function adds a run of input text to the output just as it is.
+
+    @param out Output pointer to the buffer.
+    @param text unsigned char array holding the text.
+    @param len size_t the number of chars in the text.
+    @return void
+*/
+static void copyText( Output *out, const unsigned char *text, size_t len ) {
+    emit( out, text, len );
+}
+
+/**
+    This function starts highlighting a literal by changing the print color to red.
+
+    @param out Output pointer to the buffer.
+    @param start size_t the offset of the literal's first byte (unused).
+    @return void
+*/
+static void openANSI( Output *out, size_t start ) {
+    emit( out, RED, sizeof( RED ) - 1 );
+}
+
+/**
+    This function stops highlighting a literal by changing the print color back to default.
+
+    @param out Output pointer to the buffer.
+    @param start size_t the offset of the literal's first byte (unused).
+    @param end size_t the offset just past the literal's last byte (unused).
+    @return void
+*/
+static void closeANSI( Output *out, size_t start, size_t end ) {
+    emit( out, RESET, sizeof( RESET ) - 1 );
+}
+
+/**
+    This function adds a run of input text to the output as HTML, with the chars HTML gives a
+    meaning to replaced by entities.
+
+    @param out Output pointer to the buffer.
+    @param text unsigned char array holding the text.
+    @param len size_t the number of chars in the text.
+    @return void
+*/
+static void escapeHTML( Output *out, const unsigned char *text, size_t len ) {
+    size_t run = 0;
+    for ( size_t i = 0; i < len; i++ ) {
+        const char *entity = text[ i ] == '<' ? "&lt;" : text[ i ] == '>' ? "&gt;"
+                             : text[ i ] == '&' ? "&amp;" : NULL;
+        if ( entity != NULL ) {
+            emit( out, text + run, i - run );
+            emit( out, entity, strlen( entity ) );
+            run = i + 1;
         }
+    }
+    emit( out, text + run, len - run );
+}
+
+/**
+    This function starts highlighting a literal by opening an HTML span.
+
+    @param out Output pointer to the buffer.
+    @param start size_t the offset of the literal's first byte (unused).
+    @return void
+*/
+static void openHTML( Output *out, size_t start ) {
+    emit( out, SPAN, sizeof( SPAN ) - 1 );
+}
+
+/**
+    This function stops highlighting a literal by closing its HTML span.
+
+    @param out Output pointer to the buffer.
+    @param start size_t the offset of the literal's first byte (unused).
+    @param end size_t the offset just past the literal's last byte (unused).
+    @return void
+*/
+static void closeHTML( Output *out, size_t start, size_t end ) {
+    emit( out, END_SPAN, sizeof( END_SPAN ) - 1 );
+}
+
+/**
+    This function leaves input text out of the output altogether.
+
+    @param out Output pointer to the buffer (unused).
+    @param text unsigned char array holding the text (unused).
+    @param len size_t the number of chars in the text (unused).
+    @return void
+*/
+static void skipText( Output *out, const unsigned char *text, size_t len ) {
+}
+
+/**
+    This function does nothing when a literal starts, for the backends that only need to know
+    about a literal once its length is known.
+
+    @param out Output pointer to the buffer (unused).
+    @param start size_t the offset of the literal's first byte (unused).
+    @return void
+*/
+static void skipOpen( Output *out, size_t start ) {
+}
+
+/**
+    This function adds a decimal number to the output.
+
+    @param out Output pointer to the buffer.
+    @param value size_t the number.
+    @param after char the char to add after the number.
+    @return void
+*/
+static void emitSize( Output *out, size_t value, char after ) {
+    char digits[ SIZE_DIGITS + 1 ];
+    size_t pos = sizeof( digits );
+    digits[ --pos ] = after;
+    do {
+        digits[ --pos ] = '0' + value % 10;
+        value /= 10;
+    } while ( value > 0 );
+    emit( out, digits + pos, sizeof( digits ) - pos );
+}
 
-        //Print the character.
+/**
+    This function adds a line with the offset and length of a literal to the output.
+
+    @param out Output pointer to the buffer.
+    @param start size_t the offset of the literal's first byte.
+    @param end size_t the offset just past the literal's last byte.
+    @return void
+*/
+static void closeOffsets( Output *out, size_t start, size_t end ) {
+    emitSize( out, start, ' ' );
+    emitSize( out, end - start, '\n' );
+}
+
+/** The output backends, the first of which is the default */
+static const Backend backends[] = {
+    { "ansi", copyText, openANSI, closeANSI },
+    { "html", escapeHTML, openHTML, closeHTML },
+    { "offsets", skipText, skipOpen, closeOffsets }
+};
+
+/** The backend highlightBlock() uses */
+static const Backend *backend = &backends[ 0 ];
+
+/**
+    This function picks the output backend highlightBlock() will use.
+
+    @param want char pointer to "ansi", "html" or "offsets".
+    @return boolean representing if there's a backend by that name
+*/
+bool chooseBackend( const char *want ) {
+    for ( size_t i = 0; i < sizeof( backends ) / sizeof( backends[ 0 ] ); i++ ) {
+        if ( strcmp( want, backends[ i ].name ) == 0 ) {
+            backend = &backends[ i ];
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+    This function picks the language whose comments and strings highlightBlock() will skip.
+
+    @param want char pointer to "c", "shell" or "python".
+    @return boolean representing if there's a language by that name
+*/
+bool chooseLanguage( const char *want ) {
+    const char *names[] = { "c", "shell", "python" };
+    const Language languages[] = { C_SOURCE, SHELL, PYTHON };
+    const char *starts[] = { "/\"'", "#\"'", "#\"'" };
+    for ( size_t i = 0; i < sizeof( names ) / sizeof( names[ 0 ] ); i++ ) {
+        if ( strcmp( want, names[ i ] ) == 0 ) {
+            language = languages[ i ];
+            for ( const char *ch = starts[ i ]; *ch; ch++ ) {
+                openers[ ( unsigned char ) *ch ] = true;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+    This function returns a new scanner, in its START state.
+
+    @param base size_t the offset in the input of the first block's first byte.
+    @return Scan the scanner.
+*/
+Scan newScan( size_t base ) {
+    return ( Scan ) { START, LIT_START, 0, base, 0, false, false, '\n' };
+}
+
+/**
+    This function tells if the char at an index of a block is escaped by the run of backslashes
+    just before it.
+
+    @param block unsigned char array holding the block's bytes.
+    @param from size_t the index the run of backslashes can't go back past.
+    @param at size_t the index of the char.
+    @return boolean representing if there's an odd number of backslashes just before the char.
+*/
+static bool isEscaped( const unsigned char *block, size_t from, size_t at ) {
+    size_t back = at;
+    while ( back > from && block[ back - 1 ] == '\\' ) {
+        back--;
+    }
+    return ( at - back ) % 2 == 1;
+}
+
+/**
+    This function sees if a comment or string starts at a byte that might start one.  A comment
+    or string that does start there is opened in the scanner.
+
+    @param block unsigned char array holding the block's bytes.
+    @param i size_t the index of the byte.
+    @param size size_t the number of bytes in the block.
+    @param last boolean representing if nothing follows the block.
+    @param scan Scan pointer to the scanner, whose state and string fields are set.
+    @return int the number of bytes that opened a comment or string, 0 if none starts here, or
+            -1 if it can't be told until the bytes after the block are seen.
+*/
+static int openQuoted( const unsigned char *block, size_t i, size_t size, bool last,
+                       Scan *scan ) {
+    unsigned char ch = block[ i ];
+    //How many bytes past this one we can see.
+    size_t ahead = size - i - 1;
+
+    if ( ch == '/' ) {
+        if ( ahead == 0 ) {
+            return last ? 0 : -1;
+        }
+        if ( block[ i + 1 ] == '/' || block[ i + 1 ] == '*' ) {
+            scan->state = block[ i + 1 ] == '/' ? LINE_COMMENT : BLOCK_COMMENT;
+            return 2;
+        }
+        return 0;
+    }
+
+    if ( ch == '#' ) {
+        //A shell comment has to start a word.
+        unsigned char before = i > 0 ? block[ i - 1 ] : scan->before;
+        if ( language == SHELL && !strchr( " \t\n;&|()", before ) ) {
+            return 0;
+        }
+        scan->state = LINE_COMMENT;
+        return 1;
+    }
+
+    //Anything else is a quote.
+    scan->state = STRING;
+    scan->quote = ch;
+    scan->triple = false;
+    scan->escapes = language != SHELL || ch == '"';
+    if ( language == PYTHON ) {
+        if ( ahead < 2 && !last ) {
+            return -1;
+        }
+        if ( ahead >= 2 && block[ i + 1 ] == ch && block[ i + 2 ] == ch ) {
+            scan->triple = true;
+            return 3;
+        }
+    }
+    return 1;
+}
+
+/**
+    This function skips over a comment or string, from a byte inside it to its end.  The end is
+    searched for with memchr(), so a long comment costs little more than a copy.  C and Python
+    strings that aren't triple quoted also end at a newline that isn't escaped, so a stray
+    quote can't hide the rest of the file.
+
+    @param block unsigned char array holding the block's bytes.
+    @param i size_t the index of a byte inside the comment or string.
+    @param size size_t the number of bytes in the block.
+    @param last boolean representing if nothing follows the block.
+    @param scan Scan pointer to the scanner, whose state is set to START at the end.
+    @param hold boolean pointer set to true if the bytes from the returned index on can't be
+                told apart until the bytes after the block are seen.
+    @return size_t the index just past the end of the comment or string, the index of the
+            newline that ends it, size if it runs on past the block, or the index to hold back
+            from.
+*/
+static size_t skipQuoted( const unsigned char *block, size_t i, size_t size, bool last,
+                          Scan *scan, bool *hold ) {
+    if ( scan->state == LINE_COMMENT ) {
+        const unsigned char *newline = memchr( block + i, '\n', size - i );
+        if ( newline == NULL ) {
+            return size;
+        }
+        scan->state = START;
+        return newline - block;
+    }
+
+    if ( scan->state == BLOCK_COMMENT ) {
+        while ( true ) {
+            const unsigned char *slash = memchr( block + i, '/', size - i );
+            if ( slash == NULL ) {
+                //A star at the very end might be the start of the end.
+                *hold = !last && size > i && block[ size - 1 ] == '*';
+                return *hold ? size - 1 : size;
+            }
+            size_t at = slash - block;
+            if ( at > i && block[ at - 1 ] == '*' ) {
+                scan->state = START;
+                return at + 1;
+            }
+            i = at + 1;
+        }
+    }
+
+    bool lines = !scan->triple && language != SHELL;
+    while ( true ) {
+        const unsigned char *quote = memchr( block + i, scan->quote, size - i );
+        size_t limit = quote != NULL ? ( size_t ) ( quote - block ) : size;
+        const unsigned char *newline = lines ? memchr( block + i, '\n', limit - i ) : NULL;
+        if ( newline != NULL ) {
+            size_t at = newline - block;
+            if ( scan->escapes && isEscaped( block, i, at ) ) {
+                i = at + 1;
+                continue;
+            }
+            scan->state = START;
+            return at;
+        }
+        if ( quote == NULL ) {
+            //Hold back a run of backslashes at the very end, since they might escape the
+            //first byte of the next block.
+            size_t back = size;
+            while ( scan->escapes && !last && back > i && block[ back - 1 ] == '\\' ) {
+                back--;
+            }
+            *hold = back < size;
+            return back;
+        }
+
+        size_t at = limit;
+        if ( scan->escapes && isEscaped( block, i, at ) ) {
+            i = at + 1;
+            continue;
+        }
+        if ( !scan->triple ) {
+            scan->state = START;
+            return at + 1;
+        }
+        if ( at + 2 >= size && !last ) {
+            *hold = true;
+            return at;
+        }
+        if ( at + 2 < size && block[ at + 1 ] == scan->quote && block[ at + 2 ] == scan->quote ) {
+            scan->state = START;
+            return at + 3;
+        }
+        i = at + 1;
+    }
+}
+
+/**
+    This function writes out the last of a block's text and leaves the scanner where the block
+    stops, for the next block.
+
+    @param block unsigned char array holding the block's bytes.
+    @param run size_t the index of the first byte that hasn't been written.
+    @param at size_t the index the block stops at.
+    @param state ScanState the state the scanner is in there.
+    @param scan Scan pointer to the scanner.
+    @param out Output pointer to the buffer the highlighted block goes in.
+    @return size_t the number of bytes of the block that were written, which is at.
+*/
+static size_t stopBlock( const unsigned char *block, size_t run, size_t at, ScanState state,
+                         Scan *scan, Output *out ) {
+    backend->text( out, block + run, at - run );
+    scan->state = state;
+    scan->base += at;
+    if ( at > 0 ) {
+        scan->before = block[ at - 1 ];
+    }
+    return at;
+}
+
+/**
+    This function highlights one block of input and writes it to output through the output
+    backend.  The text between the places a number starts or stops is handed to the backend in a
+    single run.  A number or identifier can run from one block into the next, so where the
+    scanner is at the end of the block is left in scan to be passed in with the next block.
+    Bytes at the end of the block that the literal lexer can't decide on until it sees what
+    follows them are left unwritten, and have to be passed in again at the start of the next
+    block.
+
+    @param block unsigned char array holding the block's bytes.
+    @param size size_t the number of bytes in the block, no more than BLOCK.
+    @param last boolean representing if nothing follows the block, so every byte is decided.
+    @param scan Scan pointer to where the scanner is, START for the first block.
+    @param out Output pointer to the buffer the highlighted block goes in.
+    @return size_t the number of bytes of the block that were written.
+*/
+size_t highlightBlock( const unsigned char *block, size_t size, bool last, Scan *scan,
+                       Output *out ) {
+    //Bit mask of the block's digits, letters and underscores.
+    uint64_t tokenMask[ BLOCK / MASK_BITS ];
+    classifier( block, size, tokenMask );
+
+    //Start of the text that hasn't been written out yet.
+    size_t run = 0;
+    size_t i = 0;
+    ScanState state = scan->state;
+    int literal = scan->literal;
+
+    //Where the current literal would end if nothing more of it is accepted, and the lexer's
+    //state there.  A block always starts at one of these when it starts inside a number.
+    size_t accept = 0;
+    int acceptLiteral = literal;
+
+    //A number the last block ended in still has to be finished off when nothing follows it,
+    //even if this block is empty.
+    while ( i < size || ( last && state == NUMBER ) ) {
+        if ( state == NUMBER ) {
+            //Run the lexer until it decides where the literal ends.
+            size_t end = size;
+            while ( i < size ) {
+                int next = literalNext[ literal ][ literalClasses[ block[ i ] ] ];
+                if ( next >= LIT_STATES ) {
+                    end = next == LIT_ACCEPT ? i : accept;
+                    break;
+                }
+                literal = next;
+                i++;
+                if ( literalAccepts[ literal ] ) {
+                    accept = i;
+                    acceptLiteral = literal;
+                }
+            }
+            if ( i == size && !last ) {
+                //Hold back anything past the last accepting state for the next block.
+                scan->literal = acceptLiteral;
+                return stopBlock( block, run, accept, NUMBER, scan, out );
+            }
+            if ( i == size ) {
+                //Nothing follows the block, which ends a suffix just like any other byte that
+                //can't be part of an identifier.
+                end = literalNext[ literal ][ L_OTHER ] == LIT_ACCEPT ? size : accept;
+            }
+
+            //Write the literal and change the color back to default, then go on scanning
+            //from the end of the literal.
+            backend->text( out, block + run, end - run );
+            backend->close( out, scan->start, scan->base + end );
+            run = end;
+            i = end;
+            state = START;
+        }
+        else if ( state == IDENTIFIER ) {
+            //Skip over the rest of the identifier, digits and all.
+            i = findBit( tokenMask, i, size, false );
+            if ( i < size ) {
+                state = START;
+            }
+        }
+        else if ( state != START ) {
+            //Skip to the end of the comment or string.
+            bool hold = false;
+            scan->state = state;
+            i = skipQuoted( block, i, size, last, scan, &hold );
+            if ( hold ) {
+                return stopBlock( block, run, i, state, scan, out );
+            }
+            state = scan->state;
+        }
         else {
-            printf( "%c", ch );
+            //Skip to the next identifier or number, stopping at anything on the way that
+            //might start a comment or string.
+            size_t next = findBit( tokenMask, i, size, true );
+            while ( language != PLAIN && i < next && !openers[ block[ i ] ] ) {
+                i++;
+            }
+            if ( language != PLAIN && i < next ) {
+                scan->state = state;
+                int opened = openQuoted( block, i, size, last, scan );
+                if ( opened < 0 ) {
+                    return stopBlock( block, run, i, START, scan, out );
+                }
+                state = scan->state;
+                i += opened > 0 ? opened : 1;
+                continue;
+            }
+            i = next;
+            if ( i < size && !( charClasses[ block[ i ] ] & CHAR_DIGIT ) ) {
+                state = IDENTIFIER;
+                i++;
+            }
+            else if ( i < size ) {
+                //A float can start with its decimal point, as long as the point doesn't follow
+                //part of an identifier or another number.
+                size_t first = i;
+                literal = LIT_START;
+                if ( i > run && block[ i - 1 ] == '.' &&
+                     !( charClasses[ i > 1 ? block[ i - 2 ] : scan->before ] & CHAR_TOKEN ) ) {
+                    first = i - 1;
+                    literal = LIT_DOT;
+                }
+
+                //Write everything up to the number, then change the print color to red.
+                backend->text( out, block + run, first - run );
+                scan->start = scan->base + first;
+                backend->open( out, scan->start );
+                run = first;
+                state = NUMBER;
+                accept = first;
+            }
         }
+    }
 
-        ch = getchar();
+    //Write whatever is left of the block, except a decimal point at the very end, which could
+    //start a float in the next block.
+    scan->literal = literal;
+    if ( state == START && !last && size > run && block[ size - 1 ] == '.' ) {
+        return stopBlock( block, run, size - 1, state, scan, out );
     }
-    //Exit successfully.
-    return 0;
+    return stopBlock( block, run, size, state, scan, out );
+}
+
+/**
+    This function highlights a run of text of any size, a block at a time.  Nothing follows the
+    text, so a number at its very end is finished off.
+
+    @param text unsigned char array holding the text.
+    @param size size_t the number of bytes in the text.
+    @param base size_t the offset of the text's first byte in the input.
+    @param out Output pointer to the buffer the highlighted text goes in.
+    @return void
+*/
+void highlightText( const unsigned char *text, size_t size, size_t base, Output *out ) {
+    Scan scan = newScan( base );
+    size_t pos = 0;
+    while ( pos < size ) {
+        size_t len = size - pos < BLOCK ? size - pos : BLOCK;
+        size_t used = highlightBlock( text + pos, len, pos + len == size, &scan, out );
+
+        //A literal lexer that can't decide on a whole block has to take what it has so far.
+        if ( used == 0 ) {
+            used = highlightBlock( text + pos, len, true, &scan, out );
+        }
+        pos += used;
+    }
+}
+
+/**
+    This function highlights one chunk of a mapped file into the chunk's own output buffer.
+    Every chunk starts just after a byte that can't be part of a literal or an identifier,
+    where the scanner is always back in its START state, so each chunk is highlighted exactly
+    the way it would be if the whole file were read in order.
+
+    @param job MagicJob pointer to the file being highlighted.
+    @param chunk Chunk pointer to the chunk to highlight.
+    @return void
+*/
+void highlightChunk( const MagicJob *job, Chunk *chunk ) {
+    highlightText( job->data + chunk->start, chunk->end - chunk->start, chunk->start,
+                   &chunk->out );
+}
+
+/**
+    This function is run by each thread in the pool.  It keeps taking the next chunk, as long as
+    it isn't too far ahead of the chunks that have been written, until there are none left.
+
+    @param arg void pointer to the MagicJob the thread is working on.
+    @return void pointer that is always NULL.
+*/
+void *highlightChunks( void *arg ) {
+    MagicJob *job = arg;
+
+    while ( true ) {
+        pthread_mutex_lock( &job->lock );
+        while ( job->next < job->count && job->next >= job->written + AHEAD ) {
+            pthread_cond_wait( &job->changed, &job->lock );
+        }
+        size_t index = job->next++;
+        pthread_mutex_unlock( &job->lock );
+        if ( index >= job->count ) {
+            break;
+        }
+
+        Chunk *chunk = &job->chunks[ index ];
+        highlightChunk( job, chunk );
+
+        pthread_mutex_lock( &job->lock );
+        chunk->done = true;
+        pthread_cond_broadcast( &job->changed );
+        pthread_mutex_unlock( &job->lock );
+    }
+    return NULL;
+}
+
+/**
+    This function reads the user's input, or a file that can't be mapped, like a pipe, and
+    highlights it as it comes in.  Each read takes
+    whatever the input has ready, up to a block, so a pipe or terminal is highlighted a line at a
+    time instead of waiting for a whole block, and the output is written out whenever there's no
+    more input ready.  Bytes a read leaves undecided are kept in the reader when it's refilled,
+    so they're scanned again with the next read.
+
+    @param fd int the file descriptor to read from.
+    @param name char pointer to the name of the file, or NULL for standard input.
+    @return void
+*/
+void highlightInput( int fd, const char *name ) {
+    static char text[ OUTBUFFER ];
+    Output out = { text, 0, sizeof( text ), false, NULL, NULL };
+    Scan scan = newScan( 0 );
+    Reader in;
+    if ( !openReader( &in, fd, BLOCK ) ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit( ERRIO );
+    }
+    bool last = false;
+    while ( !last ) {
+        refillReaderOnce( &in );
+        if ( in.error ) {
+            flushOutput( &out );
+            if ( name == NULL ) {
+                fprintf( stderr, "Can't read input\n" );
+            }
+            else {
+                fprintf( stderr, "Can't read file: %s\n", name );
+            }
+            exit( ERRIO );
+        }
+        last = in.eof;
+        size_t size = in.len - in.pos;
+        size_t used = highlightBlock( in.data + in.pos, size, last, &scan, &out );
+        if ( used == 0 && size == in.capacity ) {
+            used = highlightBlock( in.data + in.pos, size, true, &scan, &out );
+        }
+        in.pos += used;
+
+        //If the next read would wait, let the user see what we have so far.
+        struct pollfd ready = { fd, POLLIN, 0 };
+        if ( !last && poll( &ready, 1, 0 ) == 0 ) {
+            flushOutput( &out );
+            fflush( stdout );
+        }
+    }
+    flushOutput( &out );
+    scanned = scan.base;
+    closeReader( &in );
+}
+
+/**
+    This function highlights a whole file with a pool of threads.  The file is memory-mapped
+    and split into chunks of about CHUNK bytes, each ending just after a byte that can't be part
+    of a literal or identifier.  This thread writes the chunks out in order as they're finished.
+    When comments and strings are being skipped, any byte could be inside one, so the file is
+    highlighted as a single chunk.  Anything that isn't a regular file, like a pipe or a
+    device, can't be mapped and doesn't have a size, so it's read as it comes in instead.
+
+    @param name char pointer to the name of the file.
+    @param threads int the number of threads to use, or 0 for one per online processor.
+    @return void
+*/
+void highlightFile( const char *name, int threads ) {
+    int fd = open( name, O_RDONLY );
+    struct stat info;
+    if ( fd < 0 || fstat( fd, &info ) != 0 ) {
+        fprintf( stderr, "Can't open file: %s\n", name );
+        exit( ERRIO );
+    }
+    if ( !S_ISREG( info.st_mode ) ) {
+        highlightInput( fd, name );
+        close( fd );
+        return;
+    }
+    size_t size = info.st_size;
+    scanned = size;
+    if ( size == 0 ) {
+        close( fd );
+        return;
+    }
+    const unsigned char *data = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( data == MAP_FAILED ) {
+        fprintf( stderr, "Can't map file: %s\n", name );
+        exit( ERRIO );
+    }
+    posix_madvise( ( void * ) data, size, POSIX_MADV_SEQUENTIAL );
+
+    //Split the file up, moving each split forward to just after a byte that ends any token.
+    MagicJob job;
+    job.data = data;
+    job.chunks = malloc( ( size / CHUNK + 1 ) * sizeof( Chunk ) );
+    if ( job.chunks == NULL ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit( ERRIO );
+    }
+    job.count = 0;
+    for ( size_t start = 0; start < size; ) {
+        size_t end = size - start > CHUNK && language == PLAIN ? start + CHUNK : size;
+        while ( end < size && literalClasses[ data[ end - 1 ] ] != L_OTHER ) {
+            end++;
+        }
+        Chunk *chunk = &job.chunks[ job.count++ ];
+        chunk->start = start;
+        chunk->end = end;
+        chunk->out = ( Output ) { NULL, 0, 0, true, NULL, NULL };
+        chunk->done = false;
+        start = end;
+    }
+    job.next = 0;
+    job.written = 0;
+    pthread_mutex_init( &job.lock, NULL );
+    pthread_cond_init( &job.changed, NULL );
+
+    //Start the pool, with no more threads than there are chunks to go around.
+    if ( threads <= 0 ) {
+        threads = sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if ( threads > ( int ) job.count ) {
+        threads = job.count;
+    }
+    if ( threads < 1 ) {
+        threads = 1;
+    }
+    pthread_t *pool = malloc( threads * sizeof( pthread_t ) );
+    int started = 0;
+    while ( pool != NULL && started < threads &&
+            pthread_create( &pool[ started ], NULL, highlightChunks, &job ) == 0 ) {
+        started++;
+    }
+
+    //Write the chunks out in order.  If no threads would start, this thread highlights every
+    //chunk itself as it goes.
+    for ( size_t index = 0; index < job.count; index++ ) {
+        Chunk *chunk = &job.chunks[ index ];
+        if ( started == 0 ) {
+            highlightChunk( &job, chunk );
+            chunk->done = true;
+        }
+        pthread_mutex_lock( &job.lock );
+        while ( !chunk->done ) {
+            pthread_cond_wait( &job.changed, &job.lock );
+        }
+        pthread_mutex_unlock( &job.lock );
+
+        flushOutput( &chunk->out );
+        free( chunk->out.text );
+
+        pthread_mutex_lock( &job.lock );
+        job.written++;
+        pthread_cond_broadcast( &job.changed );
+        pthread_mutex_unlock( &job.lock );
+    }
+
+    for ( int i = 0; i < started; i++ ) {
+        pthread_join( pool[ i ], NULL );
+    }
+    pthread_cond_destroy( &job.changed );
+    pthread_mutex_destroy( &job.lock );
+    free( pool );
+    free( job.chunks );
+    munmap( ( void * ) data, size );
+}
+
+/**
+    This function returns the number of milliseconds on the monotonic clock.
+
+    @return long long the time in milliseconds.
+*/
+static long long now() {
+    struct timespec time;
+    clock_gettime( CLOCK_MONOTONIC, &time );
+    return ( long long ) time.tv_sec * 1000 + time.tv_nsec / NS_PER_MS;
+}
+
+/**
+    This function waits until a followed file might have grown.  With inotify it waits for the
+    file to be modified, but never longer than POLL milliseconds, so a file that's replaced or
+    truncated is still noticed.  Without inotify it just sleeps for POLL milliseconds.
+
+    @param watch int the inotify descriptor watching the file, or -1 if there isn't one.
+    @return void
+*/
+static void waitForGrowth( int watch ) {
+#ifdef MAGIC_INOTIFY
+    if ( watch >= 0 ) {
+        struct pollfd ready = { watch, POLLIN, 0 };
+        if ( poll( &ready, 1, POLL ) > 0 ) {
+            //Drain the events, they only matter as a wake-up.
+            char events[ BLOCK ];
+            while ( read( watch, events, sizeof( events ) ) > 0 ) {
+            }
+        }
+        return;
+    }
+#endif
+    struct timespec pause = { POLL / 1000, POLL % 1000 * NS_PER_MS };
+    nanosleep( &pause, NULL );
+}
+
+/**
+    This function follows a file as it grows, highlighting what's already in it and then every
+    append as it comes in, until the program is killed.  The scanner's state is kept from one
+    append to the next, so a number that's written in two pieces is highlighted as one.  The
+    output is written in batches, whenever the file has been read up to its end, or whenever
+    text has been waiting LATENCY milliseconds while more input keeps coming.  A file that gets
+    truncated is followed again from its start, and a file that's replaced by a new one under
+    the same name, as a rotated log is, is read to its end and then the new one is followed.
+
+    @param name char pointer to the name of the file.
+    @return void
+*/
+void followFile( const char *name ) {
+    static char text[ OUTBUFFER ];
+    int fd = open( name, O_RDONLY );
+    if ( fd < 0 ) {
+        fprintf( stderr, "Can't open file: %s\n", name );
+        exit( ERRIO );
+    }
+    Reader in;
+    if ( !openReader( &in, fd, BLOCK ) ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit( ERRIO );
+    }
+
+    int watch = -1;
+#ifdef MAGIC_INOTIFY
+    int watched = -1;
+    watch = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( watch >= 0 && ( watched = inotify_add_watch( watch, name, IN_MODIFY ) ) < 0 ) {
+        close( watch );
+        watch = -1;
+    }
+#endif
+
+    Output out = { text, 0, sizeof( text ), false, NULL, NULL };
+    Scan scan = newScan( 0 );
+    long long waiting = 0;
+
+    while ( true ) {
+        size_t got = refillReader( &in );
+        if ( in.error ) {
+            fprintf( stderr, "Can't read file: %s\n", name );
+            exit( ERRIO );
+        }
+
+        if ( got > 0 ) {
+            //Highlight what came in, holding back any bytes that aren't decided yet.
+            size_t size = in.len - in.pos;
+            size_t used = highlightBlock( in.data + in.pos, size, false, &scan, &out );
+            if ( used == 0 && size == in.capacity ) {
+                used = highlightBlock( in.data + in.pos, size, true, &scan, &out );
+            }
+            in.pos += used;
+
+            //Keep batching while input keeps coming, but not for too long.
+            if ( out.len > 0 && waiting == 0 ) {
+                waiting = now();
+            }
+            if ( waiting != 0 && now() - waiting >= LATENCY ) {
+                flushOutput( &out );
+                fflush( stdout );
+                waiting = 0;
+            }
+            continue;
+        }
+
+        //We're at the end of the file for now, so write out everything so far.
+        flushOutput( &out );
+        fflush( stdout );
+        waiting = 0;
+        waitForGrowth( watch );
+
+        //If the file got shorter than what we've read of it, finish off what we had and start
+        //over from its beginning.
+        struct stat info;
+        if ( fstat( fd, &info ) != 0 ) {
+            continue;
+        }
+        if ( ( size_t ) info.st_size < in.offset + in.len ) {
+            highlightBlock( in.data + in.pos, in.len - in.pos, true, &scan, &out );
+            scan = newScan( 0 );
+            lseek( fd, 0, SEEK_SET );
+            restartReader( &in );
+            continue;
+        }
+
+        //If the name is now another file, once we've read everything in the old one, finish
+        //off what we had and follow the new one from its beginning.  Until there's a new file
+        //to open, we keep following the old one.
+        struct stat named;
+        if ( stat( name, &named ) != 0 || ( named.st_dev == info.st_dev &&
+                                            named.st_ino == info.st_ino ) ||
+             ( size_t ) info.st_size > in.offset + in.len ) {
+            continue;
+        }
+        int next = open( name, O_RDONLY );
+        if ( next < 0 ) {
+            continue;
+        }
+        highlightBlock( in.data + in.pos, in.len - in.pos, true, &scan, &out );
+        scan = newScan( 0 );
+        close( fd );
+        fd = next;
+        in.fd = fd;
+        restartReader( &in );
+#ifdef MAGIC_INOTIFY
+        if ( watch >= 0 ) {
+            inotify_rm_watch( watch, watched );
+            watched = inotify_add_watch( watch, name, IN_MODIFY );
+        }
+#endif
+    }
+}
+
+/**
+    This function hashes a literal's text with FNV-1a.
+
+    @param text unsigned char array holding the text.
+    @param len size_t the number of chars in the text.
+    @return uint64_t the hash.
+*/
+static uint64_t hashText( const unsigned char *text, size_t len ) {
+    uint64_t hash = FNV_OFFSET;
+    for ( size_t i = 0; i < len; i++ ) {
+        hash = ( hash ^ text[ i ] ) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+    This function finds the slot of a table that holds a literal, or the empty slot it would
+    go in.
+
+    @param table Table pointer to the table.
+    @param text unsigned char array holding the literal's text.
+    @param len size_t the number of chars in the text.
+    @param hash uint64_t the hash of the text.
+    @return Literal pointer to the slot.
+*/
+static Literal *findSlot( const Table *table, const unsigned char *text, size_t len,
+                          uint64_t hash ) {
+    size_t mask = table->capacity - 1;
+    for ( size_t i = hash & mask; ; i = ( i + 1 ) & mask ) {
+        Literal *slot = &table->slots[ i ];
+        if ( slot->text == NULL || ( slot->hash == hash && slot->len == len &&
+                                     memcmp( slot->text, text, len ) == 0 ) ) {
+            return slot;
+        }
+    }
+}
+
+/**
+    This function makes a table of literals twice as big, or gives an empty table its first
+    slots.
+
+    @param table Table pointer to the table.
+    @return void
+*/
+static void growTable( Table *table ) {
+    Table bigger = { NULL, table->capacity ? table->capacity * 2 : TABLE_START, table->count,
+                     table->file };
+    bigger.slots = calloc( bigger.capacity, sizeof( Literal ) );
+    if ( bigger.slots == NULL ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit( ERRIO );
+    }
+    for ( size_t i = 0; i < table->capacity; i++ ) {
+        Literal *slot = &table->slots[ i ];
+        if ( slot->text != NULL ) {
+            *findSlot( &bigger, ( unsigned char * ) slot->text, slot->len, slot->hash ) = *slot;
+        }
+    }
+    free( table->slots );
+    *table = bigger;
+}
+
+/**
+    This function finds a literal in a table, adding it with a count of 0 if it isn't there yet.
+
+    @param table Table pointer to the table.
+    @param text unsigned char array holding the literal's text.
+    @param len size_t the number of chars in the text.
+    @param hash uint64_t the hash of the text.
+    @return Literal pointer to the literal's slot.
+*/
+static Literal *countLiteral( Table *table, const unsigned char *text, size_t len,
+                              uint64_t hash ) {
+    //Keep the table no more than half full.
+    if ( ( table->count + 1 ) * 2 > table->capacity ) {
+        growTable( table );
+    }
+    Literal *slot = findSlot( table, text, len, hash );
+    if ( slot->text == NULL ) {
+        slot->text = malloc( len );
+        if ( slot->text == NULL ) {
+            fprintf( stderr, "Out of memory\n" );
+            exit( ERRIO );
+        }
+        memcpy( slot->text, text, len );
+        slot->len = len;
+        slot->hash = hash;
+        slot->count = 0;
+        slot->found = 0;
+        table->count++;
+    }
+    return slot;
+}
+
+/**
+    This function adds a place a literal was found to its first locations, if it comes before
+    any of them, keeping them in order of file and then offset.
+
+    @param literal Literal pointer to the literal.
+    @param location Location the place it was found.
+    @return void
+*/
+static void addLocation( Literal *literal, Location location ) {
+    int i = literal->found;
+    while ( i > 0 && ( literal->first[ i - 1 ].file > location.file ||
+                       ( literal->first[ i - 1 ].file == location.file &&
+                         literal->first[ i - 1 ].offset > location.offset ) ) ) {
+        i--;
+    }
+    if ( i == LOCATIONS ) {
+        return;
+    }
+    int last = literal->found < LOCATIONS ? literal->found : LOCATIONS - 1;
+    memmove( &literal->first[ i + 1 ], &literal->first[ i ], ( last - i ) * sizeof( Location ) );
+    literal->first[ i ] = location;
+    if ( literal->found < LOCATIONS ) {
+        literal->found++;
+    }
+}
+
+/**
+    This function counts a literal in the table of the output it's found for, instead of
+    highlighting it.  The output's input has to be the whole file, so the literal's text can be
+    looked up by its offset.  Literals are found in the order they're in the file, so the
+    newlines since the last one are counted to find the line it's on.
+
+    @param out Output pointer whose table the literal is counted in.
+    @param start size_t the offset of the literal's first byte.
+    @param end size_t the offset just past the literal's last byte.
+    @return void
+*/
+static void closeStats( Output *out, size_t start, size_t end ) {
+    Table *table = out->table;
+    const unsigned char *newline;
+    while ( ( newline = memchr( out->input + table->counted, '\n',
+                                start - table->counted ) ) != NULL ) {
+        table->line++;
+        table->counted = newline - out->input + 1;
+    }
+    table->counted = start;
+
+    const unsigned char *text = out->input + start;
+    Literal *literal = countLiteral( table, text, end - start, hashText( text, end - start ) );
+    literal->count++;
+    addLocation( literal, ( Location ) { table->file, start, table->line } );
+}
+
+/** The backend that counts literals for the statistics instead of writing anything */
+static const Backend statsBackend = { "stats", skipText, skipOpen, closeStats };
+
+/** Structure holding everything the threads share while counting literals */
+typedef struct {
+    /** Names of the files */
+    char **names;
+    /** Number of files */
+    int count;
+    /** The next file that hasn't been handed to a thread yet */
+    int next;
+    /** True if any file couldn't be read */
+    bool failed;
+    /** Lock protecting next, failed and the count of bytes scanned */
+    pthread_mutex_t lock;
+} StatsJob;
+
+/** Structure holding one thread's part in counting literals */
+typedef struct {
+    /** The job the thread is working on */
+    StatsJob *job;
+    /** The thread's own table of literals */
+    Table table;
+} StatsWorker;
+
+/**
+    This function loads a whole file into memory.  A regular file is mapped.  Anything else,
+    like a pipe or a device, can't be mapped and doesn't have a size, so it's read to its end
+    into a buffer that grows as it fills.
+
+    @param name char pointer to the name of the file.
+    @param size size_t pointer set to the number of bytes in the file.
+    @param mapped boolean pointer set to true if the contents are mapped, and false if they're
+                  in a buffer that has to be freed.
+    @return unsigned char pointer to the file's contents, NULL if it's empty, or MAP_FAILED if
+            it can't be opened, mapped or read.
+*/
+static const unsigned char *loadFile( const char *name, size_t *size, bool *mapped ) {
+    int fd = open( name, O_RDONLY );
+    struct stat info;
+    if ( fd < 0 || fstat( fd, &info ) != 0 ) {
+        if ( fd >= 0 ) {
+            close( fd );
+        }
+        return MAP_FAILED;
+    }
+    *mapped = S_ISREG( info.st_mode );
+    if ( *mapped ) {
+        *size = info.st_size;
+        const unsigned char *data = NULL;
+        if ( *size > 0 ) {
+            data = mmap( NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        }
+        close( fd );
+        return data;
+    }
+
+    unsigned char *data = NULL;
+    size_t capacity = 0;
+    *size = 0;
+    while ( true ) {
+        if ( *size == capacity ) {
+            capacity = capacity == 0 ? BLOCK : capacity * 2;
+            unsigned char *bigger = realloc( data, capacity );
+            if ( bigger == NULL ) {
+                fprintf( stderr, "Out of memory\n" );
+                exit( ERRIO );
+            }
+            data = bigger;
+        }
+        ssize_t got = read( fd, data + *size, capacity - *size );
+        if ( got > 0 ) {
+            *size += got;
+        }
+        else if ( got == 0 || errno != EINTR ) {
+            close( fd );
+            if ( got < 0 ) {
+                free( data );
+                return MAP_FAILED;
+            }
+            break;
+        }
+    }
+    if ( *size == 0 ) {
+        free( data );
+        return NULL;
+    }
+    return data;
+}
+
+/**
+    This function is run by each thread counting literals.  It keeps taking the next file and
+    counting its literals in the thread's own table until there are none left.
+
+    @param arg void pointer to the thread's StatsWorker.
+    @return void pointer that is always NULL.
+*/
+void *countFiles( void *arg ) {
+    StatsWorker *worker = arg;
+    StatsJob *job = worker->job;
+    Output out = { NULL, 0, 0, true, NULL, &worker->table };
+
+    while ( true ) {
+        pthread_mutex_lock( &job->lock );
+        int index = job->next++;
+        pthread_mutex_unlock( &job->lock );
+        if ( index >= job->count ) {
+            break;
+        }
+
+        size_t size;
+        bool mapped;
+        const unsigned char *data = loadFile( job->names[ index ], &size, &mapped );
+        if ( data == MAP_FAILED ) {
+            fprintf( stderr, "Can't open file: %s\n", job->names[ index ] );
+            pthread_mutex_lock( &job->lock );
+            job->failed = true;
+            pthread_mutex_unlock( &job->lock );
+            continue;
+        }
+        pthread_mutex_lock( &job->lock );
+        scanned += size;
+        pthread_mutex_unlock( &job->lock );
+        if ( data != NULL ) {
+            if ( mapped ) {
+                posix_madvise( ( void * ) data, size, POSIX_MADV_SEQUENTIAL );
+            }
+            out.input = data;
+            worker->table.file = index;
+            worker->table.counted = 0;
+            worker->table.line = 1;
+            highlightText( data, size, 0, &out );
+            if ( mapped ) {
+                munmap( ( void * ) data, size );
+            }
+            else {
+                free( ( void * ) data );
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+    This function merges one table of literals into another, adding up the counts and keeping
+    the first locations of both.  The table merged from is emptied.
+
+    @param into Table pointer to the table to merge into.
+    @param from Table pointer to the table to merge from.
+    @return void
+*/
+void mergeTable( Table *into, Table *from ) {
+    for ( size_t i = 0; i < from->capacity; i++ ) {
+        Literal *slot = &from->slots[ i ];
+        if ( slot->text != NULL ) {
+            Literal *literal = countLiteral( into, ( unsigned char * ) slot->text, slot->len,
+                                             slot->hash );
+            literal->count += slot->count;
+            for ( int j = 0; j < slot->found; j++ ) {
+                addLocation( literal, slot->first[ j ] );
+            }
+            free( slot->text );
+        }
+    }
+    free( from->slots );
+    *from = ( Table ) { NULL, 0, 0, 0, 0, 0 };
+}
+
+/**
+    This function compares two literals for the report, most often found first and then in
+    order of their text, for qsort().
+
+    @param a void pointer to the first Literal pointer.
+    @param b void pointer to the second Literal pointer.
+    @return int negative, zero or positive as the first literal goes before, with or after the
+            second.
+*/
+static int compareLiterals( const void *a, const void *b ) {
+    const Literal *x = *( Literal * const * ) a;
+    const Literal *y = *( Literal * const * ) b;
+    if ( x->count != y->count ) {
+        return x->count > y->count ? -1 : 1;
+    }
+    int order = memcmp( x->text, y->text, x->len < y->len ? x->len : y->len );
+    if ( order != 0 ) {
+        return order;
+    }
+    return x->len < y->len ? -1 : x->len > y->len;
+}
+
+/**
+    This function counts every literal in a list of files with a pool of threads, then prints a
+    report of every literal found, most often found first.  Each line of the report gives the
+    number of times the literal was found, the literal, and the file and line of the first few
+    places it was found.  Every thread counts into its own table, and the tables are merged
+    once all the files are done.
+
+    @param names char pointer array holding the names of the files.
+    @param count int the number of files.
+    @param threads int the number of threads to use, or 0 for one per online processor.
+    @return int 0 if every file was read, otherwise ERRIO.
+*/
+int reportStats( char **names, int count, int threads ) {
+    StatsJob job = { names, count, 0, false };
+    pthread_mutex_init( &job.lock, NULL );
+    backend = &statsBackend;
+
+    //Start the pool, with no more threads than there are files to go around.
+    if ( threads <= 0 ) {
+        threads = sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if ( threads > count ) {
+        threads = count;
+    }
+    if ( threads < 1 ) {
+        threads = 1;
+    }
+    StatsWorker *workers = calloc( threads, sizeof( StatsWorker ) );
+    pthread_t *pool = malloc( threads * sizeof( pthread_t ) );
+    if ( workers == NULL || pool == NULL ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit( ERRIO );
+    }
+    int started = 0;
+    for ( int i = 0; i < threads; i++ ) {
+        workers[ i ].job = &job;
+        growTable( &workers[ i ].table );
+    }
+    while ( started < threads &&
+            pthread_create( &pool[ started ], NULL, countFiles, &workers[ started ] ) == 0 ) {
+        started++;
+    }
+
+    //If no threads would start, this thread counts every file itself.
+    if ( started == 0 ) {
+        countFiles( &workers[ 0 ] );
+    }
+    for ( int i = 0; i < started; i++ ) {
+        pthread_join( pool[ i ], NULL );
+    }
+    for ( int i = 1; i < threads; i++ ) {
+        mergeTable( &workers[ 0 ].table, &workers[ i ].table );
+    }
+    Table *table = &workers[ 0 ].table;
+
+    //Sort the literals for the report.
+    Literal **literals = malloc( ( table->count + 1 ) * sizeof( Literal * ) );
+    if ( literals == NULL ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit( ERRIO );
+    }
+    size_t found = 0;
+    for ( size_t i = 0; i < table->capacity; i++ ) {
+        if ( table->slots[ i ].text != NULL ) {
+            literals[ found++ ] = &table->slots[ i ];
+        }
+    }
+    qsort( literals, found, sizeof( Literal * ), compareLiterals );
+
+    for ( size_t i = 0; i < found; i++ ) {
+        printf( "%zu %.*s", literals[ i ]->count, ( int ) literals[ i ]->len, literals[ i ]->text );
+        for ( int j = 0; j < literals[ i ]->found; j++ ) {
+            printf( " %s:%zu", names[ literals[ i ]->first[ j ].file ],
+                    literals[ i ]->first[ j ].line );
+        }
+        printf( "\n" );
+        free( literals[ i ]->text );
+    }
+
+    free( literals );
+    free( table->slots );
+    free( workers );
+    free( pool );
+    pthread_mutex_destroy( &job.lock );
+    return job.failed ? ERRIO : 0;
+}
+
+/**
+    This function prints a report of the program's throughput to standard error: the megabytes
+    scanned, the time taken, megabytes a second, and the read and write system calls made for
+    each megabyte, which Linux keeps count of in /proc/self/io.  Page faults are reported too,
+    since a mapped file is read through them instead of through read calls.
+
+    @param start timespec pointer to the time the program started scanning.
+    @return void
+*/
+void reportRun( const struct timespec *start ) {
+    fflush( stdout );
+    struct timespec end;
+    clock_gettime( CLOCK_MONOTONIC, &end );
+    double seconds = end.tv_sec - start->tv_sec + ( end.tv_nsec - start->tv_nsec ) / 1e9;
+    double megabytes = scanned / 1e6;
+
+    long long reads = 0;
+    long long writes = 0;
+    FILE *io = fopen( "/proc/self/io", "r" );
+    if ( io != NULL ) {
+        char line[ 64 ];
+        while ( fgets( line, sizeof( line ), io ) != NULL ) {
+            sscanf( line, "syscr: %lld", &reads );
+            sscanf( line, "syscw: %lld", &writes );
+        }
+        fclose( io );
+    }
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+
+    fprintf( stderr, "magic: %.2f MB in %.3f s, %.1f MB/s, %.2f syscalls/MB (%lld reads, "
+             "%lld writes), %ld page faults\n", megabytes, seconds,
+             seconds > 0 ? megabytes / seconds : 0.0,
+             megabytes > 0 ? ( reads + writes ) / megabytes : 0.0, reads, writes,
+             usage.ru_minflt + usage.ru_majflt );
+}
+
+/**
+    This function prints a usage message to standard error and exits.
+
+    @return void
+*/
+void usage() {
+    fprintf( stderr, "usage: magic [-k scalar|sse2|avx2] [-o ansi|html|offsets] "
+             "[-l c|shell|python] [-r] [-t threads | -f] [input-file]\n"
+             "       magic -s [-k scalar|sse2|avx2] [-l c|shell|python] [-r] [-t threads] "
+             "input-file...\n" );
+    exit( ERRUSAGE );
+}
+
+/**
+    This is our main function which runs the program, reading in the users input a block at a
+    time and highlighting each block.  The -k option picks which classifier to use, otherwise
+    the fastest one the processor supports is used.  The -o option picks the output backend,
+    ANSI colors by default, and the -l option picks a language whose comments and strings are
+    left plain.  If a file is named, it's highlighted by a pool of threads instead, as many as
+    the -t option gives (0, the default, for one per processor), or with the -f option it's
+    followed as it grows.  With the -s option, the literals in every file named are counted and
+    reported instead.  The -r option reports the throughput and system calls on standard error
+    when it's done.
+
+    @param argc int the number of command line arguments.
+    @param argv char** array holding the command line arguments.
+    @return int representing exit success
+*/
+int main( int argc, char **argv ) {
+    const char *want = NULL;
+    int threads = -1;
+    bool follow = false;
+    bool stats = false;
+    bool report = false;
+
+    int opt;
+    while ( ( opt = getopt( argc, argv, "fk:l:o:rst:" ) ) != -1 ) {
+        if ( opt == 'k' ) {
+            want = optarg;
+        }
+        else if ( opt == 'l' ) {
+            if ( !chooseLanguage( optarg ) ) {
+                fprintf( stderr, "Unsupported language: %s\n", optarg );
+                exit( ERRUSAGE );
+            }
+        }
+        else if ( opt == 'o' ) {
+            if ( !chooseBackend( optarg ) ) {
+                fprintf( stderr, "Unsupported output: %s\n", optarg );
+                exit( ERRUSAGE );
+            }
+        }
+        else if ( opt == 't' ) {
+            char extra;
+            if ( sscanf( optarg, "%d%c", &threads, &extra ) != 1 || threads < 0 ) {
+                usage();
+            }
+        }
+        else if ( opt == 'f' ) {
+            follow = true;
+        }
+        else if ( opt == 's' ) {
+            stats = true;
+        }
+        else if ( opt == 'r' ) {
+            report = true;
+        }
+        else {
+            usage();
+        }
+    }
+    if ( ( argc - optind > 1 && !stats ) || ( ( threads >= 0 || follow || stats ) &&
+                                               optind == argc ) ||
+         ( follow && ( threads >= 0 || stats ) ) ) {
+        usage();
+    }
+    if ( !chooseClassifier( want ) ) {
+        fprintf( stderr, "Unsupported classifier: %s\n", want );
+        exit( ERRUSAGE );
+    }
+    buildLiterals();
+
+    struct timespec start;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    int status = 0;
+    if ( stats ) {
+        status = reportStats( argv + optind, argc - optind, threads );
+    }
+    else if ( follow ) {
+        followFile( argv[ optind ] );
+    }
+    else if ( optind < argc ) {
+        highlightFile( argv[ optind ], threads );
+    }
+    else {
+        highlightInput( STDIN_FILENO, NULL );
+    }
+    if ( report ) {
+        reportRun( &start );
+    }
+
+    //Exit with the status, which is success unless a file couldn't be read.
+    return status;
 }
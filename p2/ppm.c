@@ -0,0 +1,170 @@
+/**
+    @file ppm.c
+    @author Scott Spencer (wsspence)
+
+    This file handles reading and writing .ppm images.  It understands both the ASCII "P3"
+    format and the binary "P6" format, and it moves pixels a whole row at a time so the program
+    doesn't pay for a formatted read or print on every color sample.  ASCII numbers are parsed
+    by the scanning library straight out of the reader's buffer, which also skips "#" comments.
+*/
+
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing the function prototypes for these functions. */
+#include "ppm.h"
+
+/** Constant for the number of chars a one byte ASCII sample takes up, "%3d " style. */
+#define SAMPLE_WIDTH 4
+/** Constant for the most chars a two byte ASCII sample takes up, five digits and a space. */
+#define WIDE_SAMPLE_WIDTH 6
+/** Constant for the number of bits in a byte. */
+#define BYTE_BITS 8
+
+/**
+    This function is documented in ppm.h.
+*/
+int readHeader( Reader *in, PPMHeader *header ) {
+    //If the first two chars of input are not P3 or P6, it is not a ppm image.
+    if (readChar(in) != 'P') {
+        return ERRFILE;
+    }
+    int fileType = readChar(in);
+    if (fileType == PPM_ASCII[1]) {
+        header->binary = false;
+    }
+    else if (fileType == PPM_BINARY[1]) {
+        header->binary = true;
+    }
+    else {
+        return ERRFILE;
+    }
+
+    //Read the x and y sizes of the image.
+    //If they don't parse as ints or are less than 2, it's a header error.
+    if (!scanInt(in, &header->width) || !scanInt(in, &header->height) || header->width < 2 ||
+            header->height < 2) {
+        return ERRHEAD;
+    }
+
+    //Read in the maximum color intensity for the image, it's an error if it's not 1 to 65535.
+    if (!scanInt(in, &header->maxIntensity) || header->maxIntensity < 1 ||
+            header->maxIntensity > WIDE_WEIGHT) {
+        return ERRHEAD;
+    }
+    header->depth = header->maxIntensity > WEIGHT ? 2 : 1;
+
+    //Binary pixels start right after the single whitespace char that ends the header.
+    if (header->binary && readChar(in) == EOF) {
+        return ERRHEAD;
+    }
+    return 0;
+}
+
+/**
+    This function is documented in ppm.h.
+*/
+int formatHeader( char *text, size_t size, const PPMHeader *header ) {
+    //The PPM identifier, the width and height, and the intensity, each on their own line.
+    return snprintf(text, size, "%s\n%d %d\n%d\n", header->binary ? PPM_BINARY : PPM_ASCII,
+                    header->width, header->height, header->maxIntensity);
+}
+
+/**
+    This function is documented in ppm.h.
+*/
+void writeHeader( FILE *out, const PPMHeader *header ) {
+    char text[HEADER_MAX];
+    fwrite(text, 1, formatHeader(text, sizeof(text), header), out);
+}
+
+/**
+    This function is documented in ppm.h.
+*/
+bool readRow( Reader *in, const PPMHeader *header, unsigned char *row ) {
+    //Binary rows are already laid out the way we want them.
+    if (header->binary) {
+        return readBytes(in, row, rowSize(header)) == rowSize(header);
+    }
+
+    //ASCII rows have to be parsed one sample at a time, and every sample must be in range.
+    size_t count = (size_t) header->width * RGBNUM;
+    for (size_t i = 0; i < count; i++) {
+        int sample;
+        if (!scanInt(in, &sample) || sample > header->maxIntensity) {
+            return false;
+        }
+        if (header->depth == 1) {
+            row[i] = sample;
+        }
+        else {
+            row[2 * i] = sample >> BYTE_BITS;
+            row[2 * i + 1] = sample;
+        }
+    }
+    return true;
+}
+
+/**
+    This function is documented in ppm.h.
+*/
+void writeRow( FILE *out, const PPMHeader *header, const unsigned char *row, char *text ) {
+    if (header->binary) {
+        fwrite(row, 1, rowSize(header), out);
+        return;
+    }
+
+    //Format each sample right-justified in (at least) three columns followed by a space (the
+    //same thing printf("%3d ") would give us), then end the row with a newline.
+    size_t count = (size_t) header->width * RGBNUM;
+    char *pos = text;
+    if (header->depth == 1) {
+        for (size_t i = 0; i < count; i++) {
+            int sample = row[i];
+            pos[0] = sample >= 100 ? '0' + sample / 100 : ' ';
+            pos[1] = sample >= 10 ? '0' + sample / 10 % 10 : ' ';
+            pos[2] = '0' + sample % 10;
+            pos[3] = ' ';
+            pos += SAMPLE_WIDTH;
+        }
+    }
+    else {
+        for (size_t i = 0; i < count; i++) {
+            int sample = row[2 * i] << BYTE_BITS | row[2 * i + 1];
+
+            //Write the digits backwards into a scratch buffer, then pad and copy them.
+            char digits[WIDE_SAMPLE_WIDTH];
+            int len = 0;
+            do {
+                digits[len++] = '0' + sample % 10;
+                sample /= 10;
+            } while (sample > 0);
+            for (int pad = len; pad < SAMPLE_WIDTH - 1; pad++) {
+                *pos++ = ' ';
+            }
+            while (len > 0) {
+                *pos++ = digits[--len];
+            }
+            *pos++ = ' ';
+        }
+    }
+    *pos++ = '\n';
+    fwrite(text, 1, pos - text, out);
+}
+
+/**
+    This function is documented in ppm.h.
+*/
+size_t rowSize( const PPMHeader *header ) {
+    return (size_t) header->width * RGBNUM * header->depth;
+}
+
+/**
+    This function is documented in ppm.h.
+*/
+size_t rowTextSize( const PPMHeader *header ) {
+    //Every sample plus the newline at the end of the row.
+    int width = header->depth == 1 ? SAMPLE_WIDTH : WIDE_SAMPLE_WIDTH;
+    return (size_t) header->width * RGBNUM * width + 1;
+}
@@ -0,0 +1,130 @@
+/**
+    @file ppm.h
+    @author Scott Spencer (wsspence)
+
+    This header file contains the constants, types and function prototypes for reading and
+    writing .ppm images.  Images are moved a whole row at a time through a reusable buffer of
+    interleaved RGB samples, whether the file is the ASCII "P3" flavor or the binary "P6" flavor.
+    Images with a maximum intensity over 255 have two byte samples, which are always kept most
+    significant byte first in a row buffer, the same way binary files store them.
+*/
+
+#ifndef _PPM_H_
+#define _PPM_H_
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+/** Header file containing boolean operations we will use. */
+#include <stdbool.h>
+/** Header file containing the reader images are read through. */
+#include "scan.h"
+
+/** Constant for exit status when there is a file type error. */
+#define ERRFILE 100
+/** Constant for exit status when there is another header error. */
+#define ERRHEAD 101
+/** Constant for exit status when there is an image error. */
+#define ERRIMG 102
+/** Constant for exit status when a file can't be opened, mapped or written. */
+#define ERRIO 1
+/** Constant for the number of color definitions in a ppm pixel. */
+#define RGBNUM 3
+/** Constant for the largest maximum intensity that fits in one byte samples. */
+#define WEIGHT 255
+/** Constant for the largest maximum intensity we accept, which needs two byte samples. */
+#define WIDE_WEIGHT 65535
+/** Constant for the magic number of an ASCII .ppm file. */
+#define PPM_ASCII "P3"
+/** Constant for the magic number of a binary .ppm file. */
+#define PPM_BINARY "P6"
+/** Constant for a size that any formatted .ppm header fits in. */
+#define HEADER_MAX 64
+/** Constant for the size of the stdio buffers on the input and output streams. */
+#define IOBUFFER ( 1 << 20 )
+
+/** Structure describing everything in a .ppm header we need to read or write an image. */
+typedef struct {
+    /** True if the image is stored as binary (P6), false if it is ASCII (P3). */
+    bool binary;
+    /** Number of pixels in each row. */
+    int width;
+    /** Number of rows in the image. */
+    int height;
+    /** Maximum intensity of any color sample. */
+    int maxIntensity;
+    /** Number of bytes each sample takes up in a row, 1 or 2. */
+    int depth;
+} PPMHeader;
+
+/**
+    This function reads a .ppm header from the given reader, checking the magic number, the
+    image dimensions and the maximum intensity.  For a binary image the single whitespace
+    character that ends the header is consumed as well, so the reader is left at the first
+    pixel.
+
+    @param in Reader pointer to the reader we are reading the image from.
+    @param header PPMHeader pointer that will be filled in with the header values.
+    @return int 0 if the header is valid, otherwise ERRFILE or ERRHEAD.
+*/
+int readHeader( Reader *in, PPMHeader *header );
+
+/**
+    This function formats a .ppm header for the given image into a string.
+
+    @param text char array the header is written to.
+    @param size size_t the number of chars text has room for.
+    @param header PPMHeader pointer describing the image.
+    @return int the length of the formatted header.
+*/
+int formatHeader( char *text, size_t size, const PPMHeader *header );
+
+/**
+    This function prints a .ppm header for the given image to the given stream.
+
+    @param out FILE pointer to the stream we are writing the image to.
+    @param header PPMHeader pointer describing the image.
+    @return void
+*/
+void writeHeader( FILE *out, const PPMHeader *header );
+
+/**
+    This function reads one row of pixels into the given buffer as interleaved RGB samples.
+
+    @param in Reader pointer to the reader we are reading the image from.
+    @param header PPMHeader pointer describing the image.
+    @param row unsigned char array with room for rowSize( header ) bytes.
+    @return bool true if a full row of valid samples was read.
+*/
+bool readRow( Reader *in, const PPMHeader *header, unsigned char *row );
+
+/**
+    This function writes one row of interleaved RGB samples to the given stream.  ASCII rows are
+    formatted into the text buffer first so the whole row goes out in a single write.
+
+    @param out FILE pointer to the stream we are writing the image to.
+    @param header PPMHeader pointer describing the image.
+    @param row unsigned char array holding rowSize( header ) bytes of samples.
+    @param text char array with room for rowTextSize( header ) chars (unused for binary rows).
+    @return void
+*/
+void writeRow( FILE *out, const PPMHeader *header, const unsigned char *row, char *text );
+
+/**
+    This function returns the number of bytes a row of this image takes up in a row buffer,
+    which is also the number of bytes it takes up in a binary file.
+
+    @param header PPMHeader pointer describing the image.
+    @return size_t the size of a row of samples.
+*/
+size_t rowSize( const PPMHeader *header );
+
+/**
+    This function returns the number of chars an ASCII row of this image needs when it's
+    formatted by writeRow().
+
+    @param header PPMHeader pointer describing the image.
+    @return size_t the size of the text buffer writeRow() needs.
+*/
+size_t rowTextSize( const PPMHeader *header );
+
+#endif
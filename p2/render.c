@@ -0,0 +1,329 @@
+/**
+    @file render.c
+    @author Scott Spencer (wsspence)
+
+    This file holds the frame renderers.  The serial renderer streams one row at a time through
+    reusable buffers.  The multi-threaded renderer memory-maps both files, so no thread ever
+    waits on a read or a write call.  Its threads take bands of rows from a shared counter, copy
+    each row of the band from the input mapping to the output mapping, and shade the copy in
+    place, so every thread only ever writes to its own rows of the output.
+*/
+
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing the POSIX thread functions we will use. */
+#include <pthread.h>
+/** Header file containing the open() and posix_fallocate() functions and open()'s flags. */
+#include <fcntl.h>
+/** Header file containing the memory mapping functions we will use. */
+#include <sys/mman.h>
+/** Header file containing the fstat() function we will use. */
+#include <sys/stat.h>
+/** Header file containing the close() and sysconf() functions we will use. */
+#include <unistd.h>
+/** Header file containing the clock_gettime() function we will use. */
+#include <time.h>
+/** Header file containing the weight map functions. */
+#include "weight.h"
+/** Header file containing the blend kernel functions. */
+#include "blend.h"
+/** Header file containing the function prototypes for these functions. */
+#include "render.h"
+
+/** Constant for the number of rows in each band handed to a thread. */
+#define BAND_ROWS 32
+
+/** Structure holding everything the threads share while rendering an image. */
+typedef struct {
+    /** Header describing the image. */
+    const PPMHeader *header;
+    /** Weight map for the image. */
+    const WeightMap *map;
+    /** The frame's red, green and blue values, scaled to the image's maximum intensity. */
+    uint16_t border[RGBNUM];
+    /** First pixel of the input mapping. */
+    const unsigned char *src;
+    /** First pixel of the output mapping. */
+    unsigned char *dst;
+    /** Number of bytes in a row of pixels. */
+    size_t rowSize;
+    /** The next band that hasn't been handed to a thread yet. */
+    int nextBand;
+    /** Lock protecting nextBand. */
+    pthread_mutex_t lock;
+} RenderJob;
+
+/** Where the renderers add up their times, or NULL when they aren't being timed. */
+static RenderTimes *times = NULL;
+
+/**
+    This function is documented in render.h.
+*/
+void timeRenderers( RenderTimes *start ) {
+    times = start;
+}
+
+/**
+    This function adds the time since the last mark to one of the stages, and moves the mark up
+    to now.
+
+    @param stage double pointer to the stage's total seconds.
+    @param mark struct timespec pointer to the time the stage started.
+    @return void
+*/
+static void lap( double *stage, struct timespec *mark ) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    *stage += now.tv_sec - mark->tv_sec + ( now.tv_nsec - mark->tv_nsec ) / 1e9;
+    *mark = now;
+}
+
+/**
+    This function is documented in render.h.
+*/
+int renderStream( Reader *in, const PPMHeader *header, FILE *out, const unsigned char *border,
+                  RowBuffers *buffers ) {
+    //Look up the frame's weight for every pixel of an image this size.
+    const WeightMap *map = getWeightMap(header->width, header->height);
+    if (map == NULL) {
+        return ERRIMG;
+    }
+
+    //Make sure there's one row of samples, one row of blend factors and one row of formatted
+    //text, keeping the old buffers if they're already big enough.
+    if (buffers->rowSize < rowSize(header)) {
+        unsigned char *row = realloc(buffers->row, rowSize(header));
+        if (row == NULL) {
+            return ERRIMG;
+        }
+        buffers->row = row;
+        buffers->rowSize = rowSize(header);
+    }
+    if (buffers->width < header->width) {
+        uint32_t *factors = realloc(buffers->factors, (size_t) header->width * sizeof(uint32_t));
+        if (factors == NULL) {
+            return ERRIMG;
+        }
+        buffers->factors = factors;
+        buffers->width = header->width;
+    }
+    if (!header->binary && buffers->textSize < rowTextSize(header)) {
+        char *text = realloc(buffers->text, rowTextSize(header));
+        if (text == NULL) {
+            return ERRIMG;
+        }
+        buffers->text = text;
+        buffers->textSize = rowTextSize(header);
+    }
+
+    uint16_t color[RGBNUM];
+    scaleBorder(border, header->maxIntensity, color);
+    writeHeader(out, header);
+
+    //Read, shade and write the image a row at a time.
+    struct timespec mark;
+    if (times != NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &mark);
+    }
+    for (int y = 0; y < header->height; y++) {
+        if (!readRow(in, header, buffers->row)) {
+            //Body of image error, missing or invalid RGB value.
+            return ERRIMG;
+        }
+        if (times != NULL) {
+            lap(&times->parse, &mark);
+        }
+        shadeRow(map, y, buffers->row, buffers->factors, header->depth, color);
+        if (times != NULL) {
+            lap(&times->shade, &mark);
+        }
+        writeRow(out, header, buffers->row, buffers->text);
+        if (times != NULL) {
+            lap(&times->emit, &mark);
+        }
+    }
+
+    //Count flushing whatever is left in the output buffer as writing, too.
+    if (times != NULL) {
+        fflush(out);
+        lap(&times->emit, &mark);
+        times->pixels += (long long) header->width * header->height;
+    }
+    return 0;
+}
+
+/**
+    This function is documented in render.h.
+*/
+void freeRowBuffers( RowBuffers *buffers ) {
+    free(buffers->row);
+    free(buffers->factors);
+    free(buffers->text);
+    buffers->row = NULL;
+    buffers->factors = NULL;
+    buffers->text = NULL;
+    buffers->width = 0;
+    buffers->rowSize = 0;
+    buffers->textSize = 0;
+}
+
+/**
+    This function is run by each thread in the pool.  It keeps taking the next band of rows
+    until there are none left.
+
+    @param arg void pointer to the RenderJob the thread is working on.
+    @return void pointer that is always NULL.
+*/
+static void *renderBands( void *arg ) {
+    RenderJob *job = arg;
+    int height = job->header->height;
+
+    //Each thread has its own row of blend factors.
+    uint32_t *factors = malloc((size_t) job->header->width * sizeof(uint32_t));
+    if (factors == NULL) {
+        return NULL;
+    }
+
+    while (true) {
+        pthread_mutex_lock(&job->lock);
+        int band = job->nextBand++;
+        pthread_mutex_unlock(&job->lock);
+
+        int first = band * BAND_ROWS;
+        if (first >= height) {
+            break;
+        }
+        int last = first + BAND_ROWS < height ? first + BAND_ROWS : height;
+
+        //Copy the rows over, then shade the copies where they are.
+        memcpy(job->dst + first * job->rowSize, job->src + first * job->rowSize,
+               (last - first) * job->rowSize);
+        for (int y = first; y < last; y++) {
+            shadeRow(job->map, y, job->dst + y * job->rowSize, factors, job->header->depth,
+                     job->border);
+        }
+    }
+
+    free(factors);
+    return NULL;
+}
+
+/**
+    This function is documented in render.h.
+*/
+int renderMapped( Reader *in, const PPMHeader *header, const char *outName, int threads,
+                  const unsigned char *border ) {
+    struct timespec mark;
+    if (times != NULL) {
+        clock_gettime(CLOCK_MONOTONIC, &mark);
+    }
+    RenderJob job;
+    job.header = header;
+    scaleBorder(border, header->maxIntensity, job.border);
+    job.rowSize = rowSize(header);
+    job.nextBand = 0;
+
+    //The pixels start wherever reading the header left the reader.
+    size_t offset = readerOffset(in);
+    size_t pixels = job.rowSize * header->height;
+
+    //Map the whole input file, and make sure it has every pixel in it.
+    struct stat info;
+    if (fstat(in->fd, &info) != 0) {
+        return ERRIO;
+    }
+    if ((size_t) info.st_size < offset + pixels) {
+        return ERRIMG;
+    }
+    unsigned char *src = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, in->fd, 0);
+    if (src == MAP_FAILED) {
+        return ERRIO;
+    }
+    posix_madvise(src, info.st_size, POSIX_MADV_SEQUENTIAL);
+    job.src = src + offset;
+
+    //Make the output file exactly big enough for the header and pixels, and map it too.  The
+    //blocks are reserved up front, since running out of space while the threads write through
+    //the mapping would raise SIGBUS instead of giving us an error.
+    char text[HEADER_MAX];
+    int headerLen = formatHeader(text, sizeof(text), header);
+    size_t outSize = headerLen + pixels;
+    int fd = open(outName, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) {
+        munmap(src, info.st_size);
+        return ERRIO;
+    }
+    unsigned char *dst = MAP_FAILED;
+    if (posix_fallocate(fd, 0, outSize) == 0) {
+        dst = mmap(NULL, outSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (dst == MAP_FAILED) {
+        munmap(src, info.st_size);
+        return ERRIO;
+    }
+    memcpy(dst, text, headerLen);
+    job.dst = dst + headerLen;
+
+    //The weight map has to be built before the threads start, since they all share it.
+    job.map = getWeightMap(header->width, header->height);
+    if (job.map == NULL) {
+        munmap(src, info.st_size);
+        munmap(dst, outSize);
+        return ERRIMG;
+    }
+
+    //Start the pool, with no more threads than there are bands to go around.
+    if (threads <= 0) {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    int bands = (header->height + BAND_ROWS - 1) / BAND_ROWS;
+    if (threads > bands) {
+        threads = bands;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (times != NULL) {
+        lap(&times->parse, &mark);
+    }
+    pthread_t *pool = malloc(threads * sizeof(pthread_t));
+    pthread_mutex_init(&job.lock, NULL);
+    int started = 0;
+    while (pool != NULL && started < threads &&
+           pthread_create(&pool[started], NULL, renderBands, &job) == 0) {
+        started++;
+    }
+
+    //If no threads would start, this thread does all the bands itself.
+    if (started == 0) {
+        renderBands(&job);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(pool[i], NULL);
+    }
+    pthread_mutex_destroy(&job.lock);
+    free(pool);
+    if (times != NULL) {
+        lap(&times->shade, &mark);
+    }
+
+    //A thread that can't get memory for its factors quits without taking a band, so make sure
+    //some thread got through every band before calling the output finished.
+    int status = job.nextBand >= bands ? 0 : ERRIMG;
+    //munmap() doesn't report writeback errors, so flush the output ourselves first.
+    munmap(src, info.st_size);
+    if (msync(dst, outSize, MS_SYNC) != 0 && status == 0) {
+        status = ERRIO;
+    }
+    if (munmap(dst, outSize) != 0 && status == 0) {
+        status = ERRIO;
+    }
+    if (times != NULL) {
+        lap(&times->emit, &mark);
+        times->pixels += (long long) header->width * header->height;
+    }
+    return status;
+}
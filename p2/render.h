@@ -0,0 +1,97 @@
+/**
+    @file render.h
+    @author Scott Spencer (wsspence)
+
+    This header file contains the types and function prototypes for the frame renderers.  The
+    serial renderer streams an image a row at a time through buffers that can be reused from one
+    image to the next.  The multi-threaded renderer is meant for very large binary images: the
+    input and output files are memory-mapped, the image is split into bands of rows, and a pool
+    of threads shades the bands straight from the input mapping into their own slice of the
+    output mapping.
+*/
+
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+/** Header file containing the .ppm header type. */
+#include "ppm.h"
+
+/** Structure holding the row buffers the serial renderer reuses from one image to the next. */
+typedef struct {
+    /** One row of interleaved RGB samples. */
+    unsigned char *row;
+    /** One row of blend factors. */
+    uint32_t *factors;
+    /** One row of formatted ASCII text. */
+    char *text;
+    /** Number of pixels the factors buffer has room for. */
+    int width;
+    /** Number of bytes the row buffer has room for. */
+    size_t rowSize;
+    /** Number of chars the text buffer has room for. */
+    size_t textSize;
+} RowBuffers;
+
+/** Structure adding up how long the renderers spend on each stage of the images they frame. */
+typedef struct {
+    /** Seconds spent reading in and parsing pixels (mapping the files, for renderMapped()). */
+    double parse;
+    /** Seconds spent shading pixels. */
+    double shade;
+    /** Seconds spent formatting and writing out pixels (unmapping the output, for
+        renderMapped()). */
+    double emit;
+    /** Number of pixels framed. */
+    long long pixels;
+} RenderTimes;
+
+/**
+    This function starts or stops timing the renderers.  While timing is on, every image framed
+    adds its times and pixel count to the given structure.
+
+    @param times RenderTimes pointer the times are added to, or NULL to stop timing.
+    @return void
+*/
+void timeRenderers( RenderTimes *times );
+
+/**
+    This function frames an image one row at a time, reading it from a reader and writing it
+    to a stream.  Each row is read into a reusable buffer, shaded in place and written back out.
+    The buffers are grown if they are too small for this image, and kept for the next one.
+
+    @param in Reader pointer to the input, with the image's header already read.
+    @param header PPMHeader pointer describing the image.
+    @param out FILE pointer to the output stream.
+    @param border unsigned char array holding the frame's red, green and blue values.
+    @param buffers RowBuffers pointer to the buffers to use (all zero the first time).
+    @return int 0 on success or ERRIMG if the image body is bad.
+*/
+int renderStream( Reader *in, const PPMHeader *header, FILE *out, const unsigned char *border,
+                  RowBuffers *buffers );
+
+/**
+    This function frees the row buffers used by renderStream().
+
+    @param buffers RowBuffers pointer to the buffers to free.
+    @return void
+*/
+void freeRowBuffers( RowBuffers *buffers );
+
+/**
+    This function frames a binary image using a pool of threads.  The output is byte for byte
+    the same as the serial row-at-a-time path would give.
+
+    @param in Reader pointer reading the input file, with its header already read.
+    @param header PPMHeader pointer describing the image (it must be binary).
+    @param outName char pointer to the name of the output file, which is created or replaced.
+    @param threads int the number of threads to use, or 0 for one per online processor.
+    @param border unsigned char array holding the frame's red, green and blue values.
+    @return int 0 on success, ERRIMG if the input is too short, or ERRIO if a file can't be
+                mapped or written.
+*/
+int renderMapped( Reader *in, const PPMHeader *header, const char *outName, int threads,
+                  const unsigned char *border );
+
+#endif
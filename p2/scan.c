@@ -0,0 +1,256 @@
+/**
+    @file scan.c
+    @author Scott Spencer (wsspence)
+
+    This file handles buffered input for magic and frame.  Input is read a big chunk at a time
+    with read(), with no stdio buffer in between, and scanned right where it lands in the
+    reader's buffer.  Numbers are parsed by hand with a table lookup for each byte's class, which
+    is much quicker than fscanf(), since that has to interpret its format string and check the
+    locale for every number.
+*/
+
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing the errno variable. */
+#include <errno.h>
+/** Header file containing the read() function. */
+#include <unistd.h>
+/** Header file containing the function prototypes for these functions. */
+#include "scan.h"
+
+/** Classes of whitespace, in the table below. */
+#define SP CHAR_SPACE
+/** Classes of a decimal digit, in the table below. */
+#define DG ( CHAR_DIGIT | CHAR_TOKEN )
+/** Classes of a letter or underscore, in the table below. */
+#define ID CHAR_TOKEN
+
+/**
+    Table giving the classes of every byte, 16 bytes to a line.  Bytes past 127 are in no class,
+    so the rest of the table is left zero.
+*/
+const unsigned char charClasses[ UCHAR_MAX + 1 ] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  SP, SP, SP, SP, SP, 0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    SP, 0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    DG, DG, DG, DG, DG, DG, DG, DG, DG, DG, 0,  0,  0,  0,  0,  0,
+    0,  ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID,
+    ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, 0,  0,  0,  0,  ID,
+    0,  ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID,
+    ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, ID, 0,  0,  0,  0,  0
+};
+
+#undef SP
+#undef DG
+#undef ID
+
+/**
+    This function is documented in scan.h.
+*/
+bool openReader( Reader *reader, int fd, size_t capacity ) {
+    reader->fd = fd;
+    reader->data = malloc(capacity);
+    reader->pos = 0;
+    reader->len = 0;
+    reader->capacity = capacity;
+    reader->offset = 0;
+    reader->eof = false;
+    reader->error = false;
+    return reader->data != NULL;
+}
+
+/**
+    This function is documented in scan.h.
+*/
+void memoryReader( Reader *reader, const void *text, size_t size ) {
+    //The buffer is only ever written by a refill, which a reader without a descriptor skips.
+    reader->fd = -1;
+    reader->data = (unsigned char *) text;
+    reader->pos = 0;
+    reader->len = size;
+    reader->capacity = 0;
+    reader->offset = 0;
+    reader->eof = true;
+    reader->error = false;
+}
+
+/**
+    This function is documented in scan.h.
+*/
+void closeReader( Reader *reader ) {
+    if (reader->capacity > 0) {
+        free(reader->data);
+    }
+    reader->data = NULL;
+    reader->pos = 0;
+    reader->len = 0;
+    reader->capacity = 0;
+}
+
+/**
+    This function moves the bytes that haven't been used yet to the front of a reader's buffer,
+    and reads in after them.
+
+    @param reader Reader pointer to the reader to refill.
+    @param once boolean representing if we stop after the first read that gets anything, instead
+                of reading until the buffer is full.
+    @return size_t the number of bytes read in, 0 at the end of the input or on an error.
+*/
+static size_t fillReader( Reader *reader, bool once ) {
+    if (reader->fd < 0) {
+        return 0;
+    }
+
+    //Keep the bytes that haven't been used yet, and read in after them.
+    size_t kept = reader->len - reader->pos;
+    memmove(reader->data, reader->data + reader->pos, kept);
+    reader->offset += reader->pos;
+    reader->pos = 0;
+    reader->len = kept;
+    reader->eof = false;
+
+    //A pipe or terminal can come back short, so keep reading until there's no more.
+    while (reader->len < reader->capacity) {
+        ssize_t got = read(reader->fd, reader->data + reader->len,
+                           reader->capacity - reader->len);
+        if (got > 0) {
+            reader->len += got;
+            if (once) {
+                break;
+            }
+        }
+        else if (got == 0 || errno != EINTR) {
+            reader->eof = true;
+            reader->error = got < 0;
+            break;
+        }
+    }
+    return reader->len - kept;
+}
+
+/**
+    This function is documented in scan.h.
+*/
+size_t refillReader( Reader *reader ) {
+    return fillReader(reader, false);
+}
+
+/**
+    This function is documented in scan.h.
+*/
+size_t refillReaderOnce( Reader *reader ) {
+    return fillReader(reader, true);
+}
+
+/**
+    This function is documented in scan.h.
+*/
+void restartReader( Reader *reader ) {
+    reader->pos = 0;
+    reader->len = 0;
+    reader->offset = 0;
+    reader->eof = false;
+}
+
+/**
+    This function is documented in scan.h.
+*/
+size_t readerOffset( const Reader *reader ) {
+    return reader->offset + reader->pos;
+}
+
+/**
+    This function is documented in scan.h.
+*/
+int readChar( Reader *reader ) {
+    if (reader->pos == reader->len && refillReader(reader) == 0) {
+        return EOF;
+    }
+    return reader->data[reader->pos++];
+}
+
+/**
+    This function is documented in scan.h.
+*/
+size_t readBytes( Reader *reader, void *dest, size_t size ) {
+    unsigned char *to = dest;
+    size_t done = 0;
+    while (done < size) {
+        size_t have = reader->len - reader->pos;
+        if (have > 0) {
+            size_t count = have < size - done ? have : size - done;
+            memcpy(to + done, reader->data + reader->pos, count);
+            reader->pos += count;
+            done += count;
+        }
+        else if (reader->fd >= 0 && size - done >= reader->capacity) {
+            //The buffer is empty, and copying through it would only slow a read this big down.
+            reader->offset += reader->pos;
+            reader->pos = 0;
+            reader->len = 0;
+            ssize_t got = read(reader->fd, to + done, size - done);
+            if (got > 0) {
+                reader->offset += got;
+                done += got;
+            }
+            else if (got == 0 || errno != EINTR) {
+                reader->eof = true;
+                reader->error = got < 0;
+                break;
+            }
+        }
+        else if (refillReader(reader) == 0) {
+            break;
+        }
+    }
+    return done;
+}
+
+/**
+    This function is documented in scan.h.
+*/
+bool scanInt( Reader *reader, int *value ) {
+    //Skip whitespace and comments, refilling whenever we run off the end of the buffer.  A
+    //comment is skipped a line at a time with memchr(), and it may go on in the next chunk.
+    bool comment = false;
+    while (true) {
+        if (reader->pos == reader->len && refillReader(reader) == 0) {
+            return false;
+        }
+        int ch = reader->data[reader->pos];
+        if (comment) {
+            const unsigned char *end = memchr(reader->data + reader->pos, '\n',
+                                              reader->len - reader->pos);
+            reader->pos = end == NULL ? reader->len : (size_t) ( end - reader->data );
+            comment = end == NULL;
+        }
+        else if (charClasses[ch] & CHAR_SPACE) {
+            reader->pos++;
+        }
+        else if (ch == '#') {
+            comment = true;
+        }
+        else if (charClasses[ch] & CHAR_DIGIT) {
+            break;
+        }
+        else {
+            return false;
+        }
+    }
+
+    int number = 0;
+    do {
+        int digit = reader->data[reader->pos] - '0';
+        if (number > ( INT_MAX - digit ) / 10) {
+            return false;
+        }
+        number = number * 10 + digit;
+        reader->pos++;
+    } while (( reader->pos < reader->len || refillReader(reader) > 0 ) &&
+             ( charClasses[reader->data[reader->pos]] & CHAR_DIGIT ));
+
+    *value = number;
+    return true;
+}
@@ -0,0 +1,152 @@
+/**
+    @file scan.h
+    @author Scott Spencer (wsspence)
+
+    This header file contains the constants, types and function prototypes for the text scanning
+    library magic and frame share.  A Reader holds a refillable buffer over a file descriptor, or
+    wraps text that's already in memory, and input is scanned straight out of its buffer a chunk
+    at a time.  Bytes a scanner hasn't finished with are kept when the buffer is refilled, so a
+    token can straddle two reads.  There's a fast parser for the decimal ints in .ppm images, and
+    a table of character classes both programs look bytes up in.
+*/
+
+#ifndef _SCAN_H_
+#define _SCAN_H_
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+/** Header file containing boolean operations we will use. */
+#include <stdbool.h>
+/** Header file containing the UCHAR_MAX limit. */
+#include <limits.h>
+
+/** Constant for the character class of decimal digits. */
+#define CHAR_DIGIT 0x01
+/** Constant for the character class of chars that can be in an identifier: digits, letters and
+    underscores. */
+#define CHAR_TOKEN 0x02
+/** Constant for the character class of whitespace: space, tab, newline, vertical tab, form feed
+    and carriage return. */
+#define CHAR_SPACE 0x04
+
+/** Table giving the classes every byte is in, as a combination of the CHAR_ bits. */
+extern const unsigned char charClasses[ UCHAR_MAX + 1 ];
+
+/** Structure holding a buffer of input and where scanning is up to in it. */
+typedef struct {
+    /** File descriptor the input is read from, or -1 if it's all in memory already. */
+    int fd;
+    /** Buffer holding the input. */
+    unsigned char *data;
+    /** Index of the first byte in the buffer that hasn't been used yet. */
+    size_t pos;
+    /** Number of bytes in the buffer. */
+    size_t len;
+    /** Number of bytes the buffer has room for, or 0 if the reader doesn't own it. */
+    size_t capacity;
+    /** Offset in the input of the first byte in the buffer. */
+    size_t offset;
+    /** True once a read has come back at the end of the input (for now). */
+    bool eof;
+    /** True if a read failed. */
+    bool error;
+} Reader;
+
+/**
+    This function sets up a reader with a buffer of the given size over a file descriptor.  The
+    descriptor isn't closed by closeReader(), since the reader didn't open it.
+
+    @param reader Reader pointer to the reader to set up.
+    @param fd int the file descriptor to read from.
+    @param capacity size_t the number of bytes to buffer at a time.
+    @return bool false if there isn't enough memory for the buffer.
+*/
+bool openReader( Reader *reader, int fd, size_t capacity );
+
+/**
+    This function sets up a reader over text that's already in memory.  The text isn't copied,
+    so it has to stay put until the reader is done with it, and the reader never refills.
+
+    @param reader Reader pointer to the reader to set up.
+    @param text void pointer to the text.
+    @param size size_t the number of bytes of text.
+    @return void
+*/
+void memoryReader( Reader *reader, const void *text, size_t size );
+
+/**
+    This function frees a reader's buffer, if it has one of its own.
+
+    @param reader Reader pointer to the reader to free.
+    @return void
+*/
+void closeReader( Reader *reader );
+
+/**
+    This function moves the bytes that haven't been used yet to the front of a reader's buffer,
+    then reads until the buffer is full or the input runs out.  It can be called again after it
+    reaches the end of the input, to pick up anything appended since.
+
+    @param reader Reader pointer to the reader to refill.
+    @return size_t the number of bytes read in, 0 at the end of the input or on an error.
+*/
+size_t refillReader( Reader *reader );
+
+/**
+    This function refills a reader like refillReader(), but with just one read() that gets
+    anything, so input from a pipe or terminal can be used as soon as it arrives.
+
+    @param reader Reader pointer to the reader to refill.
+    @return size_t the number of bytes read in, 0 at the end of the input or on an error.
+*/
+size_t refillReaderOnce( Reader *reader );
+
+/**
+    This function starts a reader over from the beginning of its buffer, for when the input it's
+    reading is rewound.  Whatever was buffered is dropped.
+
+    @param reader Reader pointer to the reader to restart.
+    @return void
+*/
+void restartReader( Reader *reader );
+
+/**
+    This function returns the offset in the input of the next byte to be used.
+
+    @param reader Reader pointer to the reader.
+    @return size_t the offset.
+*/
+size_t readerOffset( const Reader *reader );
+
+/**
+    This function returns the next byte of input and moves past it.
+
+    @param reader Reader pointer to the reader.
+    @return int the byte, or EOF at the end of the input.
+*/
+int readChar( Reader *reader );
+
+/**
+    This function copies the next bytes of input out.  Whatever is already buffered is copied
+    first, and the rest is read straight into the destination if it's too big to be worth
+    buffering.
+
+    @param reader Reader pointer to the reader.
+    @param dest void pointer to where the bytes go.
+    @param size size_t the number of bytes wanted.
+    @return size_t the number of bytes copied, less than size only at the end of the input.
+*/
+size_t readBytes( Reader *reader, void *dest, size_t size );
+
+/**
+    This function reads a non-negative decimal int, skipping any whitespace and "#" comments
+    (which run to the end of the line) in front of it.  The byte that ends the number isn't
+    used.
+
+    @param reader Reader pointer to the reader.
+    @param value int pointer the number is stored in.
+    @return bool false if there's no number next in the input or it's too big for an int.
+*/
+bool scanInt( Reader *reader, int *value );
+
+#endif
@@ -9,8 +9,8 @@ testMagic() {
 
   rm -f output.txt
 
-  echo "Magic test $TESTNO: ./magic < input-m$TESTNO.txt > output.txt"
-  ./magic < input-m$TESTNO.txt > output.txt
+  echo "Magic test $TESTNO: ./magic $MAGICFLAGS < input-m$TESTNO.txt > output.txt"
+  ./magic $MAGICFLAGS < input-m$TESTNO.txt > output.txt
   STATUS=$?
 
   # Make sure the program exited with the right exit status.
@@ -32,6 +32,154 @@ testMagic() {
   return 0
 }
 
+# Function to run the magic program on a test case's input file, instead
+# of standard input, with the given options, and check its output
+testMagicFile() {
+  TESTNO=$1
+  FLAGS=$2
+  PIPE=$3
+
+  rm -f output.txt
+
+  # With a third argument, the file named is a pipe the input comes through.
+  if [ -n "$PIPE" ] ; then
+      echo "Magic test $TESTNO: cat input-m$TESTNO.txt | ./magic $FLAGS /dev/stdin > output.txt"
+      cat input-m$TESTNO.txt | ./magic $FLAGS /dev/stdin > output.txt
+      STATUS=$?
+  else
+      echo "Magic test $TESTNO: ./magic $FLAGS input-m$TESTNO.txt > output.txt"
+      ./magic $FLAGS input-m$TESTNO.txt > output.txt
+      STATUS=$?
+  fi
+
+  if [ $STATUS -ne 0 ] ; then
+      echo "**** Magic test $TESTNO FAILED - incorrect exit status. Expected: 0 Got: $STATUS"
+      FAIL=1
+      return 1
+  fi
+
+  if ! diff -q expected-m$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+      echo "**** Magic test $TESTNO FAILED - output didn't match the expected output"
+      FAIL=1
+      return 1
+  fi
+
+  echo "Magic test $TESTNO PASS"
+  return 0
+}
+
+# Function to run the magic program's statistics on the given test
+# cases' input files, with the given options, and check its report
+testMagicStats() {
+  TESTNO=$1
+  FLAGS=$2
+  shift 2
+  FILES=""
+  for INPUT in "$@" ; do
+      FILES="$FILES input-m$INPUT.txt"
+  done
+
+  rm -f output.txt
+
+  echo "Magic test $TESTNO: ./magic -s $FLAGS$FILES > output.txt"
+  ./magic -s $FLAGS $FILES > output.txt
+  STATUS=$?
+
+  if [ $STATUS -ne 0 ] ; then
+      echo "**** Magic test $TESTNO FAILED - incorrect exit status. Expected: 0 Got: $STATUS"
+      FAIL=1
+      return 1
+  fi
+
+  if ! diff -q expected-m$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+      echo "**** Magic test $TESTNO FAILED - output didn't match the expected output"
+      FAIL=1
+      return 1
+  fi
+
+  echo "Magic test $TESTNO PASS"
+  return 0
+}
+
+# Function to run the magic program following a file while a test
+# case's input is appended to it in two pieces, and check its output
+testMagicFollow() {
+  TESTNO=$1
+  ROTATE=$2
+
+  rm -f output.txt follow.txt follow.old
+
+  # A rotated file is split at a line, since the old file's last literal is
+  # finished off when it's replaced.
+  if [ -n "$ROTATE" ] ; then
+      echo "Magic test $TESTNO: ./magic -f follow.txt > output.txt, rotating to the rest of input-m$TESTNO.txt"
+      HALF=$(head -n $(( $(wc -l < input-m$TESTNO.txt) / 2 )) input-m$TESTNO.txt | wc -c)
+  else
+      echo "Magic test $TESTNO: ./magic -f follow.txt > output.txt, appending input-m$TESTNO.txt"
+      HALF=$(( $(wc -c < input-m$TESTNO.txt) / 2 ))
+  fi
+  head -c $HALF input-m$TESTNO.txt > follow.txt
+  ./magic -f follow.txt > output.txt &
+  PID=$!
+  sleep 0.5
+  if [ -n "$ROTATE" ] ; then
+      mv follow.txt follow.old
+  fi
+  tail -c +$(( HALF + 1 )) input-m$TESTNO.txt >> follow.txt
+
+  # Give it a few seconds to catch up, then stop it.
+  for TRY in 1 2 3 4 5 6 7 8 9 10 ; do
+      if diff -q expected-m$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+          break
+      fi
+      sleep 0.5
+  done
+  kill $PID
+  wait $PID 2>/dev/null
+  rm -f follow.txt follow.old
+
+  if ! diff -q expected-m$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+      echo "**** Magic test $TESTNO FAILED - output didn't match the expected output"
+      FAIL=1
+      return 1
+  fi
+
+  echo "Magic test $TESTNO PASS"
+  return 0
+}
+
+# Function to run the magic program on a pipe that stays open after a test
+# case is written to it, and make sure the highlighted text comes out before
+# the pipe is closed
+testMagicPipe() {
+  TESTNO=$1
+
+  rm -f output.txt
+
+  echo "Magic test $TESTNO: input-m$TESTNO.txt piped to ./magic > output.txt, held open"
+  { cat input-m$TESTNO.txt ; sleep 5 ; } | ./magic > output.txt &
+  PID=$!
+
+  # Give it a few seconds to catch up, then stop it.
+  for TRY in 1 2 3 4 5 6 ; do
+      if diff -q expected-m$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+          break
+      fi
+      sleep 0.5
+  done
+  kill $PID
+  wait $PID 2>/dev/null
+
+  if ! diff -q expected-m$TESTNO.txt output.txt >/dev/null 2>&1 ; then
+      echo "**** Magic test $TESTNO FAILED - output didn't match the expected output"
+      FAIL=1
+      return 1
+  fi
+
+  echo "Magic test $TESTNO PASS"
+  return 0
+}
+
 # Function to run the frame program against a test case and check its
 # output and exit status for correct behavior
 testFrame() {
@@ -40,8 +188,8 @@ testFrame() {
 
   rm -f output.ppm
 
-  echo "Frame test $TESTNO: ./frame < input-f$TESTNO.ppm > output.ppm"
-  ./frame < input-f$TESTNO.ppm > output.ppm
+  echo "Frame test $TESTNO: ./frame $FRAMEFLAGS < input-f$TESTNO.ppm > output.ppm"
+  ./frame $FRAMEFLAGS < input-f$TESTNO.ppm > output.ppm
   STATUS=$?
 
   # Make sure the program exited with the right exit status.
@@ -66,6 +214,115 @@ testFrame() {
   return 0
 }
 
+# Function to run the frame program on a test case's files, instead of
+# standard input and output, with the given options, and check its output
+# and exit status for correct behavior
+testFrameFiles() {
+  TESTNO=$1
+  ESTATUS=$2
+  FLAGS=$3
+
+  rm -f output.ppm
+
+  echo "Frame test $TESTNO: ./frame $FLAGS input-f$TESTNO.ppm output.ppm"
+  ./frame $FLAGS input-f$TESTNO.ppm output.ppm
+  STATUS=$?
+
+  # Make sure the program exited with the right exit status.
+  if [ $STATUS -ne $ESTATUS ]; then
+      echo "**** Frame test $TESTNO FAILED - incorrect exit status. Expected: $ESTATUS Got: $STATUS"
+      FAIL=1
+      return 1
+  fi
+
+  if [ $ESTATUS -eq 0 ] ; then
+      # Make sure the output matches the expected output.
+      if ! diff -q expected-f$TESTNO.ppm output.ppm >/dev/null 2>&1 ; then
+	  echo "**** Frame test $TESTNO FAILED - output didn't match the expected output"
+	  FAIL=1
+	  return 1
+      fi
+  fi
+
+  echo "Frame test $TESTNO PASS"
+  return 0
+}
+
+# Function to run the frame program with a test case's input as both its
+# input and output file, with the given options, and make sure it refuses
+# without touching the input
+testFrameSame() {
+  TESTNO=$1
+  FLAGS=$2
+
+  rm -f output.ppm
+  cp input-f$TESTNO.ppm output.ppm
+
+  echo "Frame test $TESTNO: ./frame $FLAGS output.ppm output.ppm"
+  ./frame $FLAGS output.ppm output.ppm 2>/dev/null
+  STATUS=$?
+
+  # Make sure the program exited with the usage status.
+  if [ $STATUS -ne 1 ]; then
+      echo "**** Frame test $TESTNO FAILED - incorrect exit status. Expected: 1 Got: $STATUS"
+      FAIL=1
+      return 1
+  fi
+
+  # Make sure the input is still there.
+  if ! cmp -s input-f$TESTNO.ppm output.ppm ; then
+      echo "**** Frame test $TESTNO FAILED - the input file was changed"
+      FAIL=1
+      return 1
+  fi
+
+  echo "Frame test $TESTNO PASS"
+  return 0
+}
+
+# Function to run the frame program once in batch mode over several test
+# cases that should succeed, and check every one of the output images
+testFrameBatch() {
+  rm -f output-f*.ppm
+
+  # The last two lines chain the first test's image through an intermediate output.
+  echo "Frame batch test: ./frame -b - for tests $* and a chain through test $1"
+  {
+      for TESTNO in "$@" ; do
+	  echo "input-f$TESTNO.ppm output-f$TESTNO.ppm"
+      done
+      echo "input-f$1.ppm output-fchain1.ppm"
+      echo "output-fchain1.ppm output-fchain2.ppm"
+  } | ./frame -b -
+  STATUS=$?
+
+  if [ $STATUS -ne 0 ]; then
+      echo "**** Frame batch test FAILED - incorrect exit status. Expected: 0 Got: $STATUS"
+      FAIL=1
+      return 1
+  fi
+
+  for TESTNO in "$@" ; do
+      if ! diff -q expected-f$TESTNO.ppm output-f$TESTNO.ppm >/dev/null 2>&1 ; then
+	  echo "**** Frame batch test FAILED - output $TESTNO didn't match the expected output"
+	  FAIL=1
+	  return 1
+      fi
+  done
+
+  ./frame expected-f$1.ppm output-fchain.ppm
+  if ! diff -q expected-f$1.ppm output-fchain1.ppm >/dev/null 2>&1 ||
+     ! diff -q output-fchain.ppm output-fchain2.ppm >/dev/null 2>&1 ; then
+      echo "**** Frame batch test FAILED - chained output didn't match the expected output"
+      FAIL=1
+      return 1
+  fi
+
+  rm -f output-f*.ppm
+  echo "Frame batch test PASS"
+  return 0
+}
+
 # make a fresh copy of the target programs
 make clean
 make
@@ -78,6 +335,73 @@ if [ -x magic ] ; then
     testMagic 3 0
     testMagic 4 0
     testMagic 5 0
+    testMagic 6 0
+
+    # Hex, binary, octal and float literals, with suffixes and digit
+    # separators, are each highlighted as one number.
+    testMagic 7 0
+
+    # The HTML backend puts every literal in a span and escapes the text,
+    # and the offsets backend lists each literal's offset and length.
+    MAGICFLAGS="-o html"
+    testMagic 8 0
+    MAGICFLAGS="-o offsets"
+    testMagic 9 0
+    MAGICFLAGS=""
+
+    # Numbers in the comments and strings of C, shell and Python source are
+    # left plain.
+    MAGICFLAGS="-l c"
+    testMagic 11 0
+    MAGICFLAGS="-l shell"
+    testMagic 12 0
+    MAGICFLAGS="-l python"
+    testMagic 13 0
+    MAGICFLAGS=""
+
+    # Every classifier the processor can run has to give exactly the same
+    # output as the expected text.
+    for KERNEL in scalar sse2 avx2 ; do
+        if ./magic -k $KERNEL < input-m1.txt > /dev/null 2>&1 ; then
+            MAGICFLAGS="-k $KERNEL"
+            testMagic 1 0
+            testMagic 2 0
+            testMagic 3 0
+            testMagic 4 0
+            testMagic 5 0
+            testMagic 6 0
+            testMagic 7 0
+            MAGICFLAGS=""
+        else
+            echo "Magic classifier $KERNEL isn't supported here, skipping it"
+        fi
+    done
+
+    # A file named on the command line is mapped and highlighted by a
+    # pool of threads, and has to come out the same.
+    testMagicFile 3 ""
+    testMagicFile 5 "-t 2"
+    testMagicFile 6 "-t 0"
+    testMagicFile 7 "-t 2"
+    testMagicFile 9 "-o offsets -t 2"
+    testMagicFile 11 "-l c -t 2"
+
+    # A named file that can't be mapped, like a pipe, is read as it comes in.
+    testMagicFile 5 "-t 2" pipe
+
+    # The statistics count every literal across several files, and the
+    # report has to come out the same however many threads count them.
+    # A pipe is read into memory and counted too.
+    testMagicStats 10 "-t 1" 3 4 7 9
+    testMagicStats 10 "-t 3" 3 4 7 9
+    testMagicFile 14 "-s" pipe
+
+    # Piped input is highlighted as it comes in, not when the pipe closes.
+    testMagicPipe 4
+
+    # A followed file is highlighted as it grows, and after it's rotated.
+    testMagicFollow 4
+    testMagicFollow 4 rotate
 else
     echo "**** Magic program didn't compile successfully"
     FAIL=1
@@ -92,6 +416,72 @@ if [ -x frame ] ; then
     testFrame 6 100
     testFrame 7 101
     testFrame 8 102
+    testFrame 9 0
+
+    # The frame color, window radius and falloff curve can be changed from
+    # the command line.
+    FRAMEFLAGS="-c 255,0,0 -r 0.5 -f smoothstep"
+    testFrame 10 0
+    FRAMEFLAGS=""
+
+    # A falloff curve can come from a lookup table file, which has to hold
+    # exactly 256 weights.
+    FRAMEFLAGS="-f lut:table-f16.txt"
+    testFrame 16 0
+    FRAMEFLAGS="-f lut:table-f17.txt"
+    testFrame 17 1
+    FRAMEFLAGS=""
+
+    # Sixteen bit images, binary and ASCII, and an image with a maximum
+    # intensity under 255.
+    testFrame 11 0
+    testFrame 12 0
+    testFrame 13 0
+
+    # Comments can show up anywhere whitespace can.
+    testFrame 14 0
+    testFrame 15 0
+    testFrameFiles 15 0 "-t 2"
+
+    # A 49x15 image is 25 pixels from its center to a corner, so some of
+    # its blends are exact .5 ties, which the fixed-point blend rounds by
+    # its weights' rounding error.
+    testFrame 18 0
+
+    # Every blend kernel the processor can run has to give exactly the
+    # same output as the expected images.
+    for KERNEL in scalar sse2 avx2 ; do
+        if ./frame -k $KERNEL < input-f1.ppm > /dev/null 2>&1 ; then
+            FRAMEFLAGS="-k $KERNEL"
+            testFrame 1 0
+            testFrame 2 0
+            testFrame 3 0
+            testFrame 4 0
+            testFrame 5 0
+            testFrame 9 0
+            testFrame 11 0
+            testFrame 12 0
+            testFrame 18 0
+            FRAMEFLAGS=""
+        else
+            echo "Frame kernel $KERNEL isn't supported here, skipping it"
+        fi
+    done
+
+    # The threaded renderer has to match the serial one byte for byte, and
+    # ASCII images given to it go through the serial path.
+    testFrameFiles 9 0 "-t 2"
+    testFrameFiles 9 0 "-t 0"
+    testFrameFiles 11 0 "-t 2"
+    testFrameFiles 5 0 "-t 2"
+    testFrameFiles 8 102 "-t 2"
+
+    # The output file can't be the input file, threaded or not.
+    testFrameSame 9 ""
+    testFrameSame 9 "-t 2"
+
+    # Batch mode frames a whole list of images in one run.
+    testFrameBatch 1 2 3 4 5 9 3 9 11 13
 else
     echo "**** Magic program didn't compile successfully"
     FAIL=1
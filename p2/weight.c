@@ -0,0 +1,290 @@
+/**
+    @file weight.c
+    @author Scott Spencer (wsspence)
+
+    This file builds and caches the frame's weight maps.  A pixel's weight is its percentage of
+    distance between the edge of the frame's window and the furthest pixel from the center of
+    the image (any corner).  Pixels inside the window get a weight of zero.  Weights are stored
+    as fixed-point blend factors so shading a pixel doesn't need any floating point math, and
+    any falloff curve is applied here too, once per stored pixel.
+
+    A factor is the weight rounded to 31 fraction bits, so a blended color can only come out
+    different from doing the blend in double when it's within about 1e-7 of a half.  That does
+    happen, on exact .5 ties, when an image's center-to-corner distance is a whole number (49x15
+    is one), and then the factor's rounding error, not round(), decides which way the tie goes,
+    so those samples can be one off from what the original double blend gave.
+*/
+
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing math functions we will use. */
+#include <math.h>
+/** Header file containing the function prototypes for these functions. */
+#include "weight.h"
+
+/** Constant for bisecting the X or Y coordinate plane. */
+#define INHALF 2.0
+/** Constant for the value of one-half pixel distance. */
+#define HALFPIXEL 0.5
+
+/** Constant for the most weight maps we keep around at once. */
+#define MAP_CACHE 16
+
+/** List of the weight maps we've built so far, most recently used first, so they can be
+    reused. */
+static WeightMap *cache = NULL;
+/** The curve the frame's weight falls off along. */
+static FalloffCurve falloff = FALLOFF_LINEAR;
+/** The window's radius as a fraction of the default radius. */
+static double radiusScale = 1.0;
+/** The falloff lookup table, for FALLOFF_TABLE. */
+static double falloffTable[ FALLOFF_TABLE_SIZE ];
+
+/**
+    This function is documented in weight.h.
+*/
+void setFalloff( FalloffCurve curve, double scale, const double *table ) {
+    falloff = curve;
+    radiusScale = scale;
+    if (curve == FALLOFF_TABLE) {
+        for (int i = 0; i < FALLOFF_TABLE_SIZE; i++) {
+            falloffTable[i] = table[i];
+        }
+    }
+    freeWeightMaps();
+}
+
+/**
+    This function is documented in weight.h.
+*/
+bool readFalloffTable( FILE *fp, double *table ) {
+    for (int i = 0; i < FALLOFF_TABLE_SIZE; i++) {
+        if (fscanf(fp, "%lf", &table[i]) != 1 || !(table[i] >= 0 && table[i] <= 1)) {
+            return false;
+        }
+    }
+
+    //Anything after the last weight means the table isn't the size we expect.
+    return fscanf(fp, " %*c") == EOF;
+}
+
+/**
+    This function puts a linear weight through the falloff curve.
+
+    @param w double the linear weight, from 0 at the window to 1 at the corners.
+    @return double the weight the curve gives.
+*/
+static double applyFalloff( double w ) {
+    if (falloff == FALLOFF_QUADRATIC) {
+        return w * w;
+    }
+    if (falloff == FALLOFF_SMOOTHSTEP) {
+        return w * w * (3 - 2 * w);
+    }
+    if (falloff == FALLOFF_TABLE) {
+        //Interpolate between the two table entries on either side of the weight.
+        double pos = w * (FALLOFF_TABLE_SIZE - 1);
+        int i = pos;
+        if (i >= FALLOFF_TABLE_SIZE - 1) {
+            return falloffTable[FALLOFF_TABLE_SIZE - 1];
+        }
+        return falloffTable[i] + (falloffTable[i + 1] - falloffTable[i]) * (pos - i);
+    }
+    return w;
+}
+
+/**
+    This function frees one weight map.
+
+    @param map WeightMap pointer to the map to free.
+    @return void
+*/
+static void freeWeightMap( WeightMap *map ) {
+    free(map->edges);
+    free(map->starts);
+    free(map->factors);
+    free(map);
+}
+
+/**
+    This function checks whether a pixel is outside the frame's window, using the same distance
+    calculation the shading does.
+
+    @param dy double the distance between the pixel's row and the center of the image.
+    @param dx double the distance between the pixel's column and the center of the image.
+    @param radius double the radius of the frame's window.
+    @return bool true if the pixel is outside the window.
+*/
+static bool outside( double dy, double dx, double radius ) {
+    return sqrt(dy * dy + dx * dx) > radius;
+}
+
+/**
+    This function finds how many pixels at the start of one quadrant row are outside the frame's
+    window.  The window's edge in the row comes straight from the circle's equation, and then it
+    is nudged a pixel at a time until it agrees exactly with the distance test used for shading,
+    so rounding in the two calculations can never disagree about a pixel.
+
+    @param dy double the distance between the row and the center of the image.
+    @param centerX double the X coordinate of the image's center point.
+    @param radius double the radius of the frame's window.
+    @param quadWidth int the number of pixels in the quadrant row.
+    @return int the number of pixels at the start of the row outside the window.
+*/
+static int findEdge( double dy, double centerX, double radius, int quadWidth ) {
+    //If the row doesn't reach the circle at all, all of it is outside the window.
+    if (dy * dy > radius * radius) {
+        return quadWidth;
+    }
+    int edge = ceil(centerX - sqrt(radius * radius - dy * dy));
+    if (edge < 0) {
+        edge = 0;
+    }
+    if (edge > quadWidth) {
+        edge = quadWidth;
+    }
+
+    //The pixel before the edge has to be outside the window, and the one at the edge inside it.
+    while (edge > 0 && !outside(dy, centerX - (edge - 1), radius)) {
+        edge--;
+    }
+    while (edge < quadWidth && outside(dy, centerX - edge, radius)) {
+        edge++;
+    }
+    return edge;
+}
+
+/**
+    This function builds the weight map for an image of the given size.
+
+    @param width int the number of pixels in each row of the image.
+    @param height int the number of rows in the image.
+    @return WeightMap pointer to the new map, or NULL if there isn't enough memory for it.
+*/
+static WeightMap *buildWeightMap( int width, int height ) {
+    WeightMap *map = calloc(1, sizeof(WeightMap));
+    if (map == NULL) {
+        return NULL;
+    }
+    map->width = width;
+    map->height = height;
+    map->quadWidth = (width + 1) / 2;
+    map->quadHeight = (height + 1) / 2;
+    map->edges = malloc(map->quadHeight * sizeof(int));
+    map->starts = malloc(map->quadHeight * sizeof(size_t));
+    if (map->edges == NULL || map->starts == NULL) {
+        freeWeightMap(map);
+        return NULL;
+    }
+
+    //Use x and y planes to determine the radius of the frame and its origin
+    //(Remember the frame is drawn from the center to the edge, so in an even shorter plane the
+    //edges of the frame would lay between the furthest pixels, and in an even shorter plane,
+    //the edges of the frame would not touch the furthest pixels.  Thus the -0.5).
+    double centerX = (width / INHALF) - HALFPIXEL;
+    double centerY = (height / INHALF) - HALFPIXEL;
+    double radius = (width > height ? centerY : centerX) * radiusScale;
+
+    //We can use Euclidean distance to find the Maximum Distance, since we know the max
+    //distance is just the distance from the center to any of the corners, such as 0, 0.
+    double maxDist = sqrt(centerY * centerY + centerX * centerX);
+
+    //Find where the window starts in every quadrant row, and where each row's factors go.
+    size_t total = 0;
+    for (int y = 0; y < map->quadHeight; y++) {
+        map->edges[y] = findEdge(centerY - y, centerX, radius, map->quadWidth);
+        map->starts[y] = total;
+        total += map->edges[y];
+    }
+    map->factors = malloc((total > 0 ? total : 1) * sizeof(uint32_t));
+    if (map->factors == NULL) {
+        freeWeightMap(map);
+        return NULL;
+    }
+
+    //Work out the factor for every pixel in the top left quadrant outside the window.  Mirrored
+    //pixels in the other quadrants are exactly the same distance from the center, so they share
+    //a factor.
+    for (int y = 0; y < map->quadHeight; y++) {
+        uint32_t *factors = map->factors + map->starts[y];
+        for (int x = 0; x < map->edges[y]; x++) {
+            double distance = sqrt((centerY - y) * (centerY - y) +
+                                   (centerX - x) * (centerX - x));
+            double w = (distance - radius) / (maxDist - radius);
+            factors[x] = llround(applyFalloff(w) * BLEND_ONE);
+        }
+    }
+    return map;
+}
+
+/**
+    This function is documented in weight.h.
+*/
+const WeightMap *getWeightMap( int width, int height ) {
+    //Look for a map we've already built for this size, and move it to the front of the list
+    //so the maps that go unused the longest are at the back.
+    WeightMap **link = &cache;
+    int count = 0;
+    for (WeightMap *map = cache; map != NULL; map = map->next) {
+        if (map->width == width && map->height == height) {
+            *link = map->next;
+            map->next = cache;
+            cache = map;
+            return map;
+        }
+        link = &map->next;
+        count++;
+    }
+
+    //Otherwise build one and remember it for next time, forgetting the map that has gone
+    //unused the longest if the cache is full.
+    WeightMap *map = buildWeightMap(width, height);
+    if (map != NULL) {
+        map->next = cache;
+        cache = map;
+        if (count >= MAP_CACHE) {
+            WeightMap *last = map;
+            while (last->next->next != NULL) {
+                last = last->next;
+            }
+            freeWeightMap(last->next);
+            last->next = NULL;
+        }
+    }
+    return map;
+}
+
+/**
+    This function is documented in weight.h.
+*/
+void expandRow( const WeightMap *map, int y, uint32_t *factors, int *start, int *end ) {
+    //Rows in the bottom half mirror rows in the top half.
+    if (y >= map->quadHeight) {
+        y = map->height - 1 - y;
+    }
+    const uint32_t *quad = map->factors + map->starts[y];
+    int edge = map->edges[y];
+
+    //The window runs from the edge to its mirror image, unless the whole row is outside it.
+    *start = edge;
+    *end = map->width - edge > edge ? map->width - edge : edge;
+
+    //Columns in the right half mirror columns in the left half.
+    for (int x = 0; x < edge; x++) {
+        factors[x] = quad[x];
+    }
+    for (int x = *end; x < map->width; x++) {
+        factors[x] = quad[map->width - 1 - x];
+    }
+}
+
+/**
+    This function is documented in weight.h.
+*/
+void freeWeightMaps() {
+    while (cache != NULL) {
+        WeightMap *next = cache->next;
+        freeWeightMap(cache);
+        cache = next;
+    }
+}
@@ -0,0 +1,128 @@
+/**
+    @file weight.h
+    @author Scott Spencer (wsspence)
+
+    This header file contains the constants, types and function prototypes for the frame's
+    weight map.  The weight of the frame color on a pixel only depends on where the pixel is, so
+    we work it out once per image size, as fixed-point blend factors, and look it up for every
+    row after that.  The image is symmetric about its center, so only the top left quadrant of
+    factors is stored, and the other three quadrants are mirrored from it.  Each row also knows
+    the span of pixels that falls inside the frame's window, and no factors are stored for those
+    pixels at all, since they are always copied through untouched.  The window's radius and the
+    curve the weight falls off along can be changed at run time, and they are baked into the
+    factors when a map is built, so shading costs the same whatever they are set to.
+*/
+
+#ifndef _WEIGHT_H_
+#define _WEIGHT_H_
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+/** Header file containing boolean operations we will use. */
+#include <stdbool.h>
+/** Header file containing the size_t type we will use. */
+#include <stddef.h>
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+
+/** Constant for the number of fraction bits in a fixed-point blend factor. */
+#define BLEND_SHIFT 31
+/** Constant for the blend factor of a pixel that is entirely the frame color. */
+#define BLEND_ONE ( (uint64_t) 1 << BLEND_SHIFT )
+/** Constant added before shifting a blended color so it rounds to the nearest int. */
+#define BLEND_HALF ( BLEND_ONE >> 1 )
+
+/** Constant for the number of entries in a falloff lookup table. */
+#define FALLOFF_TABLE_SIZE 256
+
+/** Type for the curves the frame's weight can fall off along, from the window to the corners. */
+typedef enum {
+    /** The weight grows in a straight line. */
+    FALLOFF_LINEAR,
+    /** The weight grows with the square of the distance, so it stays light near the window. */
+    FALLOFF_QUADRATIC,
+    /** The weight eases in near the window and eases out near the corners. */
+    FALLOFF_SMOOTHSTEP,
+    /** The weight comes from a lookup table read from a file. */
+    FALLOFF_TABLE
+} FalloffCurve;
+
+/** Structure holding the blend factors for every pixel of one image size. */
+typedef struct WeightMap {
+    /** Number of pixels in each row of the image. */
+    int width;
+    /** Number of rows in the image. */
+    int height;
+    /** Number of columns in the stored quadrant, the left half plus any middle column. */
+    int quadWidth;
+    /** Number of rows in the stored quadrant, the top half plus any middle row. */
+    int quadHeight;
+    /** For each quadrant row, the number of pixels at each end of the row outside the window. */
+    int *edges;
+    /** For each quadrant row, the index in factors of the row's first factor. */
+    size_t *starts;
+    /** Blend factors for the pixels outside the window, edges[ y ] of them for quadrant row y. */
+    uint32_t *factors;
+    /** Next weight map in the cache of maps we've already built. */
+    struct WeightMap *next;
+} WeightMap;
+
+/**
+    This function changes the window's radius and the falloff curve used for every weight map
+    built after this, and throws away any maps that were built with the old settings.
+
+    @param curve FalloffCurve the curve the weight falls off along.
+    @param radiusScale double the window's radius as a fraction of the default radius, which is
+                       half the shorter side of the image.
+    @param table double array of FALLOFF_TABLE_SIZE weights, from 0 to 1, for evenly spaced
+                 distances from the window to the corners (only used for FALLOFF_TABLE).
+    @return void
+*/
+void setFalloff( FalloffCurve curve, double radiusScale, const double *table );
+
+/**
+    This function reads a falloff lookup table of FALLOFF_TABLE_SIZE weights from a file.  The
+    weights are separated by whitespace, each one must be from 0 to 1, and nothing but
+    whitespace may follow the last one.
+
+    @param fp FILE pointer to the file holding the table.
+    @param table double array the FALLOFF_TABLE_SIZE weights are stored in.
+    @return bool true if the whole table was read, every weight is in range, and nothing
+            follows it.
+*/
+bool readFalloffTable( FILE *fp, double *table );
+
+/**
+    This function returns the weight map for an image of the given size.  Maps are cached, so
+    every image of the same size after the first one reuses the map that was already built.
+    Only the most recently used sizes are kept, so the pointer is good until the next call.
+
+    @param width int the number of pixels in each row of the image.
+    @param height int the number of rows in the image.
+    @return WeightMap pointer to the map, or NULL if there isn't enough memory for it.
+*/
+const WeightMap *getWeightMap( int width, int height );
+
+/**
+    This function finds the span of one row of the image that is inside the frame's window, and
+    fills in a blend factor for every pixel of the row outside that span by mirroring the stored
+    quadrant.  Factors for pixels inside the window are left alone.
+
+    @param map WeightMap pointer to the map for the image.
+    @param y int the row's Y coordinate in the image.
+    @param factors uint32_t array with room for one factor per pixel in the row.
+    @param start int pointer set to the X coordinate of the first pixel inside the window.
+    @param end int pointer set to one past the X coordinate of the last pixel inside the window
+               (equal to start if none of the row is inside it).
+    @return void
+*/
+void expandRow( const WeightMap *map, int y, uint32_t *factors, int *start, int *end );
+
+/**
+    This function frees every weight map in the cache.
+
+    @return void
+*/
+void freeWeightMaps();
+
+#endif
@@ -25,62 +25,161 @@
 #define BLUE "\033[34m" //(033 is octal representation of ascii decimal 27)
 /** Constant sequence of chars representing the default color */
 #define DEFAULT "\033[0m"
+/** Constant for the size of a cache line, which the tiles are aligned to */
+#define CACHE_LINE 64
+
+/**
+    This function allocates memory that starts on a cache line.
+    @param size size_t the number of bytes needed.
+    @return void pointer to the memory, or NULL if there isn't enough.
+*/
+static void *allocAligned( size_t size ) {
+    void *memory;
+    if ( posix_memalign( &memory, CACHE_LINE, size ) != 0 ) {
+        return NULL;
+    }
+    return memory;
+}
 
 /**
     This function is documented in board.h.
 */
-void initBoard( int rows, int cols, int board[][ cols ] ) {
-    int counter = 0;
-    int i = 0;
-    int j = 0;
-    for (i = 0; i < rows; i++) {
-        for (j = 0; j < cols; j++) {
-            counter++;
-            board[i][j] = counter;
-        }
+Board *makeBoard( int rows, int cols ) {
+    if ( rows < 1 || cols < 1 || rows > MAX_TILES / cols ) {
+        return NULL;
+    }
+    Board *board = malloc( sizeof( Board ) );
+    if ( board == NULL ) {
+        return NULL;
+    }
+    size_t count = (size_t) rows * cols;
+    board->rows = rows;
+    board->cols = cols;
+    board->smallTiles = NULL;
+    board->largeTiles = NULL;
+    board->position = malloc( ( count + 1 ) * sizeof( uint32_t ) );
+    board->homeTiles = 0;
+
+    //Use two bytes a tile whenever every tile number fits in them.
+    bool tilesMade;
+    if ( count <= UINT16_MAX ) {
+        board->smallTiles = allocAligned( count * sizeof( uint16_t ) );
+        tilesMade = board->smallTiles != NULL;
+    }
+    else {
+        board->largeTiles = allocAligned( count * sizeof( uint32_t ) );
+        tilesMade = board->largeTiles != NULL;
     }
-    //set to initial state
+    if ( !tilesMade || board->position == NULL ) {
+        freeBoard( board );
+        return NULL;
+    }
+    return board;
+}
+
+/**
+    This function is documented in board.h.
+*/
+void freeBoard( Board *board ) {
+    free( board->smallTiles );
+    free( board->largeTiles );
+    free( board->position );
+    free( board );
 }
 
 /**
-    This function checks whether or not our board is in the initial/solved state.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
-    @return bool telling us whether or not the board is in the solved state.
+    This function is documented in board.h.
 */
-static bool checkSolved( int rows, int cols, int board[][ cols ] ) {
-    int counter = 0;
-    for ( int i = 0; i < rows; i++ ) {
-        for ( int j = 0; j < cols; j++ ) {
-            counter++;
-            if ( board[i][j] != counter ) {
-                return false;
-            }
+void copyBoard( Board *to, Board *from ) {
+    size_t count = (size_t) from->rows * from->cols;
+    if ( from->smallTiles != NULL ) {
+        memcpy( to->smallTiles, from->smallTiles, count * sizeof( uint16_t ) );
+    }
+    else {
+        memcpy( to->largeTiles, from->largeTiles, count * sizeof( uint32_t ) );
+    }
+    memcpy( to->position, from->position, ( count + 1 ) * sizeof( uint32_t ) );
+    to->homeTiles = from->homeTiles;
+}
+
+/**
+    This function returns the tile at a position on the board, whichever size the tiles are.
+    @param board Board pointer to our board.
+    @param pos size_t the position, row * cols + column.
+    @return uint32_t the number of the tile.
+*/
+static inline uint32_t tileAt( Board *board, size_t pos ) {
+    return board->smallTiles != NULL ? board->smallTiles[pos] : board->largeTiles[pos];
+}
+
+/**
+    This function stores a tile at a position on the board, and records the position in the
+    board's tile index.  The count of tiles at home goes down if the tile being replaced was at
+    home there, and up if the new one is.
+    @param board Board pointer to our board.
+    @param pos size_t the position to put the tile in, row * cols + column.
+    @param tile uint32_t the number of the tile.
+    @return void
+*/
+static inline void placeTile( Board *board, size_t pos, uint32_t tile ) {
+    board->homeTiles += ( tile == pos + 1 ) - ( tileAt( board, pos ) == pos + 1 );
+    if ( board->smallTiles != NULL ) {
+        board->smallTiles[pos] = tile;
+    }
+    else {
+        board->largeTiles[pos] = tile;
+    }
+    board->position[tile] = pos;
+}
+
+/**
+    This function is documented in board.h.
+*/
+void initBoard( Board *board ) {
+    size_t count = (size_t) board->rows * board->cols;
+    for ( size_t pos = 0; pos < count; pos++ ) {
+        if ( board->smallTiles != NULL ) {
+            board->smallTiles[pos] = pos + 1;
+        }
+        else {
+            board->largeTiles[pos] = pos + 1;
         }
+        board->position[pos + 1] = pos;
     }
-    return true;
+    //set to initial state, with every tile at home
+    board->homeTiles = count;
 }
 
 /**
     This function is documented in board.h.
 */
-void printBoard( int rows, int cols, int board[][ cols ] ) {
-    //TO DO: loop through and print the board to standard output.  (if it's in the solved state,
-    //print it in blue)
+int getTile( Board *board, int r, int c ) {
+    return tileAt( board, (size_t) r * board->cols + c );
+}
 
+/**
+    This function is documented in board.h.
+*/
+bool checkSolved( Board *board ) {
+    return board->homeTiles == board->rows * board->cols;
+}
+
+/**
+    This function is documented in board.h.
+*/
+void printBoard( Board *board ) {
     bool solved = false;
     //check if puzzle is solved, if it is, change font color to blue
     printf("\n");
-    if ( checkSolved( rows, cols, board ) ) {
+    if ( checkSolved( board ) ) {
         printf( BLUE );
         solved = true;
     }
 
-    for ( int i = 0; i < rows; i++ ) {
+    for ( int i = 0; i < board->rows; i++ ) {
         //print starting space
-        for ( int j = 0; j < cols; j++ ) {
-            printf( " %2d", board[i][j]);
+        for ( int j = 0; j < board->cols; j++ ) {
+            printf( " %2d", getTile( board, i, j ) );
         }
         printf("\n");
     }
@@ -92,125 +191,127 @@ void printBoard( int rows, int cols, int board[][ cols ] ) {
 }
 
 /**
-    This function search for a tile in the board and returns whether or not it exists on the board.
+    This function looks up where a tile is on the board in the board's tile index, and returns
+    whether or not it exists on the board.
     @param tile int the number of the tile we want to perform the operation on.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param board Board pointer to our board.
     @param *r int a pointer passed by reference representing our target tile's row.
     @param *c int a pointer passed by reference representing our target tile's column.
     @return bool telling us whether or not the tile was found on the board.
 */
-static bool findTile( int tile, int rows, int cols, int board[][ cols ], int *r, int *c ) {
-    for ( int i = 0; i < rows; i++ ) {
-        for ( int j = 0; j < cols; j++ ) {
-            if ( board[i][j] == tile ) {
-                *r = i;  //Set the pointer value of r to the variable i
-                *c = j;  //Set the pointer value of c to the variable j
-                return true;
-            }
+static bool findTile( int tile, Board *board, int *r, int *c ) {
+    //Every tile from 1 to rows * cols is somewhere on the board, and no others are.
+    if ( tile < 1 || tile > board->rows * board->cols ) {
+        return false;
+    }
+    *r = board->position[tile] / board->cols;
+    *c = board->position[tile] % board->cols;
+    return true;
+}
+
+/**
+    This function rotates a line of the board, a row or a column, by one place.  The same loop
+    does both, since a row's tiles are one position apart and a column's are a whole row apart.
+    Each tile is read and written once, but a column's reads and writes are strided, so on a
+    wide board every tile of the column is on a cache line of its own.
+    @param board Board pointer to our board.
+    @param first size_t the position of the first tile in the line.
+    @param step size_t the distance between the positions of neighboring tiles in the line.
+    @param count int the number of tiles in the line.
+    @param backward bool true to move every tile toward the start of the line, with the first
+                    one wrapping around to the end, or false to move them the other way.
+    @return void
+*/
+static void rotateLine( Board *board, size_t first, size_t step, int count, bool backward ) {
+    size_t last = first + ( count - 1 ) * step;
+    if ( backward ) {
+        //save the first tile before it's overwritten, and move it to the end afterward
+        uint32_t temp = tileAt( board, first );
+        for ( size_t pos = first; pos != last; pos += step ) {
+            placeTile( board, pos, tileAt( board, pos + step ) );
+        }
+        placeTile( board, last, temp );
+    }
+    else {
+        //save the last tile before it's overwritten, and move it to the start afterward
+        uint32_t temp = tileAt( board, last );
+        for ( size_t pos = last; pos != first; pos -= step ) {
+            placeTile( board, pos, tileAt( board, pos - step ) );
         }
+        placeTile( board, first, temp );
     }
-    return false;
 }
 
 /**
     This function is documented in board.h.
 */
-bool moveUp( int tile, int rows, int cols, int board[][ cols ] ) {
+void shiftColumn( Board *board, int c, bool up ) {
+    rotateLine( board, c, board->cols, board->rows, up );
+}
+
+/**
+    This function is documented in board.h.
+*/
+void shiftRow( Board *board, int r, bool left ) {
+    rotateLine( board, (size_t) r * board->cols, 1, board->cols, left );
+}
+
+/**
+    This function is documented in board.h.
+*/
+bool moveUp( int tile, Board *board ) {
     int targCol;
     int targRow;
 
-    //If this doesn't change pointer vals, just go back to searching manually
-    //check if tile is in board?
-    if ( findTile(tile, rows, cols, board, &targRow, &targCol) == false ) {
+    if ( findTile(tile, board, &targRow, &targCol) == false ) {
         return false;
     }
-
-    //save the value of the first element in target column before it's overwritten
-    int temp = board[0][targCol];
-    //loop through the values in the target column, moving each value "up" until the last (which
-    //requires the first value which we have stored in temp).
-    for ( int i = 0; i < rows - 1; i++ ) {
-        board[i][targCol] = board[i + 1][targCol];
-    }
-    //set the last value in the target column to temp
-    board[rows - 1][targCol] = temp;
-
-    return true; //?
+    //move each value in the target column "up", with the first one wrapping to the bottom
+    shiftColumn( board, targCol, true );
+    return true;
 }
 
 /**
     This function is documented in board.h.
 */
-bool moveDown( int tile, int rows, int cols, int board[][ cols ] ) {
+bool moveDown( int tile, Board *board ) {
     int targCol;
     int targRow;
 
-    //If this doesn't change pointer vals, just go back to searching manually
-    //check if tile is in board?
-    if ( findTile(tile, rows, cols, board, &targRow, &targCol) == false ) {
+    if ( findTile(tile, board, &targRow, &targCol) == false ) {
         return false;
     }
-    //save the value of the last element in target column before it's overwritten
-    int temp = board[rows - 1][targCol];
-    //loop through the values in target column, moving each value "down" except the first (which
-    //requires the last value which we have stored in temp).
-    for ( int i = rows - 1; i > 0; i-- ) {
-        board[i][targCol] = board[i - 1][targCol];
-    }
-    //set the last value in the target column to temp
-    board[0][targCol] = temp;
-
-    return true; //?
+    //move each value in the target column "down", with the last one wrapping to the top
+    shiftColumn( board, targCol, false );
+    return true;
 }
 
 /**
     This function is documented in board.h.
 */
-bool moveLeft( int tile, int rows, int cols, int board[][ cols ] ) {
+bool moveLeft( int tile, Board *board ) {
     int targCol;
     int targRow;
 
-    //If this doesn't change pointer vals, just go back to searching manually
-    //check if tile is in board?
-    if ( findTile(tile, rows, cols, board, &targRow, &targCol) == false ) {
+    if ( findTile(tile, board, &targRow, &targCol) == false ) {
         return false;
     }
-    //save the value of the first element in target row before it's overwritten
-    int temp = board[targRow][0];
-    //loop through the values in the target row, moving each value "up" until the last (which
-    //requires the first value which we have stored in temp).
-    for ( int i = 0; i < cols - 1; i++ ) {
-        board[targRow][i] = board[targRow][i + 1];
-    }
-    //set the last value in the target row to temp
-    board[targRow][cols - 1] = temp;
-
-    return true; //?
+    //move each value in the target row "left", with the first one wrapping to the right end
+    shiftRow( board, targRow, true );
+    return true;
 }
 
 /**
     This function is documented in board.h.
 */
-bool moveRight( int tile, int rows, int cols, int board[][ cols ] ) {
+bool moveRight( int tile, Board *board ) {
     int targCol;
     int targRow;
 
-    //If this doesn't change pointer vals, just go back to searching manually
-    //check if tile is in board?
-    if ( findTile(tile, rows, cols, board, &targRow, &targCol) == false ) {
+    if ( findTile(tile, board, &targRow, &targCol) == false ) {
         return false;
     }
-    //save the value of the last element in target column before it's overwritten
-    int temp = board[targRow][cols - 1];
-    //loop through the values in the target row, moving each value "left" except the last (which
-    //requires the last value which we have stored in temp).
-    for ( int i = cols - 1; i > 0; i-- ) {
-        board[targRow][i] = board[targRow][i - 1];
-    }
-    //set the first value in the target column to temp
-    board[targRow][0] = temp;
-
-    return true; //?
+    //move each value in the target row "right", with the last one wrapping to the left end
+    shiftRow( board, targRow, false );
+    return true;
 }
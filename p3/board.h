@@ -6,65 +6,158 @@
     that deal with our board.
 */
 
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+
 /* A constant representing the number of rows in our board when no config file is found. */
 #define DEFAULT_ROWS 5
 /* A constant representing the number of columns in our board if no config file is found. */
 #define DEFAULT_COLS 7
+/* A constant for the most tiles a board can have, so every tile number still fits in a packed
+   move from command.h, which keeps its two low bits for the direction. */
+#define MAX_TILES ( ( 1 << 30 ) - 1 )
+
+/**
+    This structure holds our board.  The tiles are stored a row at a time on the heap, starting
+    on a cache line, as 16 bit numbers when there are few enough tiles for that and 32 bit ones
+    otherwise.  Alongside them is an index giving the position (row * cols + column) of every
+    tile, so a tile can be found without searching the board for it.  The index, and a count of
+    the tiles that are in their home position, are kept up to date by every move.
+*/
+typedef struct {
+    /* The number of rows in the board. */
+    int rows;
+    /* The number of columns in the board. */
+    int cols;
+    /* The tiles as 16 bit numbers, one row after another, or NULL if they don't fit. */
+    uint16_t *smallTiles;
+    /* The tiles as 32 bit numbers, one row after another, or NULL if they fit in 16 bits. */
+    uint32_t *largeTiles;
+    /* The position each tile is in, indexed by tile number (1 to rows * cols). */
+    uint32_t *position;
+    /* The number of tiles in their home position, which is rows * cols when it's solved. */
+    int homeTiles;
+} Board;
+
+/**
+    This function allocates a board of the given size on the heap.  Its tiles aren't set until
+    initBoard() is called.
+
+    @param rows int the number of rows in the board.
+    @param cols int the number of columns in the board.
+    @return Board pointer to the new board, or NULL if the size isn't positive, there would be
+            more than MAX_TILES tiles, or there isn't enough memory.
+*/
+Board *makeBoard( int rows, int cols );
+
+/**
+    This function frees a board and its tiles.
+
+    @param board Board pointer to the board to free.
+    @return void
+*/
+void freeBoard( Board *board );
+
+/**
+    This function copies the tiles of one board onto another board of the same size.
+
+    @param to Board pointer to the board to copy onto.
+    @param from Board pointer to the board to copy.
+    @return void
+*/
+void copyBoard( Board *to, Board *from );
 
 /**
     This function initializes the board's tile values, each tile is an int array index that
     is ordered sequentially, counting left to right and top to bottom, with 1 occupying the
-    top left index.
+    top left index.  The tile index is filled in to match.
 
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param board Board pointer to our board.
     @return void
 */
-void initBoard( int rows, int cols, int board[][ cols ] );
+void initBoard( Board *board );
+
+/**
+    This function returns the tile at a row and column of our board.
+
+    @param board Board pointer to our board.
+    @param r int the row of the tile.
+    @param c int the column of the tile.
+    @return int the number of the tile.
+*/
+int getTile( Board *board, int r, int c );
+
+/**
+    This function checks whether or not our board is in the initial/solved state.  It just
+    compares the count of tiles at home to the number of tiles, so it takes the same time for
+    any size of board.
+    @param board Board pointer to our board.
+    @return bool telling us whether or not the board is in the solved state.
+*/
+bool checkSolved( Board *board );
 
 /**
     This function prints our puzzle board.  Each tile is printed separated by a space and
     occupying at least 2 digit width.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param board Board pointer to our board.
+    @return void
+*/
+void printBoard( Board *board );
+
+/**
+    This function moves a column of the board up or down by one, with the tile that falls off one
+    end wrapping around to the other.  The tiles are stored a row at a time, so this walks the
+    board a whole row at a step, and on a wide board it touches a cache line for every row where
+    shiftRow() touches only a few.
+    @param board Board pointer to our board.
+    @param c int the column to move.
+    @param up bool true to move the column up, false to move it down.
+    @return void
+*/
+void shiftColumn( Board *board, int c, bool up );
+
+/**
+    This function moves a row of the board left or right by one, with the tile that falls off
+    one end wrapping around to the other.
+    @param board Board pointer to our board.
+    @param r int the row to move.
+    @param left bool true to move the row left, false to move it right.
     @return void
 */
-void printBoard( int rows, int cols, int board[][ cols ] );
+void shiftRow( Board *board, int r, bool left );
 
 /**
     This function moves the column of the target tile up by one, with the top-most tile
     overflowing back to the vacant bottom position.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param tile int the number of the tile we want to perform the operation on.
+    @param board Board pointer to our board.
+    @return bool telling us whether or not the tile was found on the board.
 */
-bool moveUp( int tile, int rows, int cols, int board[][ cols ] );
+bool moveUp( int tile, Board *board );
 
 /**
     This function moves the column of the target tile down by one, with the bottom-most tile
     overflowing back to the vacant bottom position.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param tile int the number of the tile we want to perform the operation on.
+    @param board Board pointer to our board.
+    @return bool telling us whether or not the tile was found on the board.
 */
-bool moveDown( int tile, int rows, int cols, int board[][ cols ] );
+bool moveDown( int tile, Board *board );
 
 /**
     This function moves the row of the target tile to the right by one, with the right-most tile
     overflowing back to the vacant left-most position.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param tile int the number of the tile we want to perform the operation on.
+    @param board Board pointer to our board.
+    @return bool telling us whether or not the tile was found on the board.
 */
-bool moveRight( int tile, int rows, int cols, int board[][ cols ] );
+bool moveRight( int tile, Board *board );
 
 /**
     This function moves the row of the target tile to the left by one, with the left-most tile
     overflowing back to the vacant right-most position.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param tile int the number of the tile we want to perform the operation on.
+    @param board Board pointer to our board.
+    @return bool telling us whether or not the tile was found on the board.
 */
-bool moveLeft( int tile, int rows, int cols, int [][ cols ] );
+bool moveLeft( int tile, Board *board );
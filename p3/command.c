@@ -5,7 +5,8 @@
 
    This program handles all the command functions that deal with configuration files such as
    skipping a line of input until a newline is found so we may process the next one and whether
-   or not a line can be successfully read from the input file.
+   or not a line can be successfully read from the input file.  It also keeps the history of
+   moves, which undo and redo walk back and forth through without any string handling.
 */
 
 /** Header file containing standard input/output functions we will use. */
@@ -42,3 +43,71 @@ bool getCommand( FILE *stream, char cmd[ CMD_LIMIT + 2 ] ) {
         return false;
     }
 }
+
+bool initHistory( History *history, int depth ) {
+    history->moves = malloc( HISTORY_START * sizeof( Move ) );
+    history->capacity = HISTORY_START;
+    history->start = 0;
+    history->count = 0;
+    history->redo = 0;
+    history->depth = depth;
+    return history->moves != NULL;
+}
+
+void freeHistory( History *history ) {
+    free( history->moves );
+    history->moves = NULL;
+    history->capacity = 0;
+    history->count = 0;
+    history->redo = 0;
+}
+
+bool pushMove( History *history, Move move ) {
+    //A new move means the undone ones can't be redone any more.
+    history->redo = 0;
+
+    //Drop the oldest move if we're as deep as we can go.
+    if ( history->depth > 0 && history->count == history->depth ) {
+        history->start = ( history->start + 1 ) & ( history->capacity - 1 );
+        history->count--;
+    }
+
+    //Double the ring when it's full, unwrapping the moves into the start of the new one.
+    if ( history->count == history->capacity ) {
+        Move *moves = malloc( 2 * history->capacity * sizeof( Move ) );
+        if ( moves == NULL ) {
+            return false;
+        }
+        int first = history->capacity - history->start;
+        memcpy( moves, history->moves + history->start, first * sizeof( Move ) );
+        memcpy( moves + first, history->moves, history->start * sizeof( Move ) );
+        free( history->moves );
+        history->moves = moves;
+        history->capacity *= 2;
+        history->start = 0;
+    }
+
+    history->moves[ ( history->start + history->count ) & ( history->capacity - 1 ) ] = move;
+    history->count++;
+    return true;
+}
+
+bool undoMove( History *history, Move *move ) {
+    if ( history->count == 0 ) {
+        return false;
+    }
+    history->count--;
+    history->redo++;
+    *move = history->moves[ ( history->start + history->count ) & ( history->capacity - 1 ) ];
+    return true;
+}
+
+bool redoMove( History *history, Move *move ) {
+    if ( history->redo == 0 ) {
+        return false;
+    }
+    *move = history->moves[ ( history->start + history->count ) & ( history->capacity - 1 ) ];
+    history->count++;
+    history->redo--;
+    return true;
+}
@@ -3,21 +3,63 @@
     @author W. Scott Spencer
 
     This is a header file that contains the prototypes for global variables, constants, and
-    functions that we use for commands that aid our reading the input configuration file.
+    functions that we use for commands that aid our reading the input configuration file, and
+    for the history of moves that can be undone and redone.  Each move is kept in the history
+    packed into a single number, its tile shifted up with its direction in the low bits, so
+    undoing or redoing one never has to parse a command again.
 */
 
-/* This is a constant for the maximum number of performed commands we will store in memory. */
+/** Header file containing fixed width integer types we will use. */
+#include <stdint.h>
+
+/* This is a constant for the number of moves that can be undone, unless it's changed with -d. */
 #define NUMCOMMANDS 10
-/* This is a constant for the maximum length of commands that we are storing in memory. */
-#define COMMANDLEN 30
 /* This is a constant for the maximum length of a command we will accept. */
 #define CMD_LIMIT 30
+/* This is a constant for the number of low bits of a packed move that hold its direction. */
+#define DIRECTION_BITS 2
+/* This is a constant for the number of moves the history has room for before it first grows. */
+#define HISTORY_START 16
+
+/* The directions a move can go in.  Each one is the opposite of the one it's paired with, so
+   flipping the lowest bit reverses a move. */
+typedef enum { MOVE_UP, MOVE_DOWN, MOVE_LEFT, MOVE_RIGHT } Direction;
+
+/* A move packed into one number, with the tile above the DIRECTION_BITS low bits.  That leaves
+   30 bits for the tile, which is why makeBoard() won't make a board of more than MAX_TILES. */
+typedef uint32_t Move;
 
-/* This global variable defined elsewhere holds the history of our commmands. */
-extern char history[ NUMCOMMANDS ][ COMMANDLEN ];
+/* This macro packs a direction and a tile into a move. */
+#define PACK_MOVE( direction, tile ) ( ( Move ) ( tile ) << DIRECTION_BITS | ( direction ) )
+/* This macro gives the direction of a packed move. */
+#define MOVE_DIRECTION( move ) ( ( Direction ) ( ( move ) & ( ( 1 << DIRECTION_BITS ) - 1 ) ) )
+/* This macro gives the tile of a packed move. */
+#define MOVE_TILE( move ) ( ( int ) ( ( move ) >> DIRECTION_BITS ) )
+
+/**
+    This structure holds the history of moves, in a ring buffer that doubles in size whenever
+    it fills up.  The moves that can be undone come first, oldest to newest, followed by the
+    ones that have been undone and can be redone.  Once the history is as deep as it's allowed
+    to be, the oldest move is dropped to make room for each new one, which just moves the start
+    of the ring along.
+*/
+typedef struct {
+    /* The ring buffer of moves. */
+    Move *moves;
+    /* The number of moves the ring buffer has room for, always a power of two. */
+    int capacity;
+    /* The index in the ring buffer of the oldest move. */
+    int start;
+    /* The number of moves that can be undone. */
+    int count;
+    /* The number of moves after those that can be redone. */
+    int redo;
+    /* The most moves that can be undone, or 0 for no limit. */
+    int depth;
+} History;
 
-/* This global variable defined elsewhere holds the number of commands held in memory. */
-extern int histLen;
+/* This global variable defined elsewhere holds the history of our moves. */
+extern History history;
 
 /**
     This function skips through the current line and the newline character to get our stream
@@ -35,3 +77,44 @@ void skipLine( FILE *stream );
     @return bool telling us if a command could be retrieved or not.
 */
 bool getCommand( FILE *stream, char cmd[ CMD_LIMIT + 2 ] );
+
+/**
+    This function sets up an empty history.
+    @param *history History pointer to the history to set up.
+    @param depth int the most moves that can be undone, or 0 for no limit.
+    @return bool false if there isn't enough memory for the history.
+*/
+bool initHistory( History *history, int depth );
+
+/**
+    This function frees the memory a history uses.
+    @param *history History pointer to the history to free.
+    @return void
+*/
+void freeHistory( History *history );
+
+/**
+    This function adds a move to the end of the history.  Any moves that could have been redone
+    are forgotten, and if the history is already as deep as it can be, so is the oldest move.
+    @param *history History pointer to the history.
+    @param move Move the packed move that was made.
+    @return bool false if there isn't enough memory to add the move.
+*/
+bool pushMove( History *history, Move move );
+
+/**
+    This function takes the newest move off the history so it can be undone, keeping it so it
+    can be redone.
+    @param *history History pointer to the history.
+    @param *move Move pointer the packed move is stored in.
+    @return bool false if there is no move to undo.
+*/
+bool undoMove( History *history, Move *move );
+
+/**
+    This function puts the most recently undone move back on the history so it can be redone.
+    @param *history History pointer to the history.
+    @param *move Move pointer the packed move is stored in.
+    @return bool false if there is no move to redo.
+*/
+bool redoMove( History *history, Move *move );
@@ -20,10 +20,14 @@
 #include <string.h>
 /** Header file containing boolean operations we will use here. */
 #include <stdbool.h>
+/** Header file containing the getopt() function we will use. */
+#include <unistd.h>
 /** Header file containing function prototypes for functions in board.c we use. */
 #include "board.h"
 /** Header file containing function prototypes for functions in command.c we use. */
 #include "command.h"
+/** Header file containing the function prototype for the solver in solver.c. */
+#include "solver.h"
 
 /* Constant representing the number of rows a board has when no config file is present. */
 #define DEFAULT_ROWS 5
@@ -33,6 +37,10 @@
 #define QUIT "quit"
 /* Constant representing the string of the "undo" command */
 #define UNDO "undo"
+/* Constant representing the string of the "redo" command */
+#define REDO "redo"
+/* Constant representing the string of the "solve" command */
+#define SOLVE "solve"
 /* Constant representing the string of the "up" command */
 #define UP "up"
 /* Constant representing the string of the "down" command */
@@ -41,59 +49,129 @@
 #define LEFT "left"
 /* Constant representing the string of the "right" command */
 #define RIGHT "right"
+/* Constant for the number of seconds the solver searches for, unless it's changed with -l */
+#define SOLVE_SECONDS 30
 /* Constant for an exit code definition */
 #define EXIT_ERROR 1
-/* Global variable for the history of commands */
-char history[ NUMCOMMANDS ][ COMMANDLEN ];
-/* Global variable for the number of commands stored in memory */
-int histLen;
+/* Constant for the usage message */
+#define USAGE "usage: puzzle [-d undo-depth] [-t threads] [-l solve-seconds] [-s] [config-file]\n"
+/* Global variable for the history of moves */
+History history;
+
+/**
+    This function moves the row or column of a tile one place in the given direction.
+    @param direction Direction the way to move the tile.
+    @param tile int the number of the tile to move.
+    @param board Board pointer to our board.
+    @return bool telling us whether or not the tile was found on the board.
+*/
+static bool applyMove( Direction direction, int tile, Board *board ) {
+    if ( direction == MOVE_UP ) {
+        return moveUp( tile, board );
+    }
+    else if ( direction == MOVE_DOWN ) {
+        return moveDown( tile, board );
+    }
+    else if ( direction == MOVE_LEFT ) {
+        return moveLeft( tile, board );
+    }
+    return moveRight( tile, board );
+}
+
+/**
+    This function undoes the newest move in the history by making the opposite move.
+    @param board Board pointer to our board.
+    @return bool false if there was no move to undo.
+*/
+static bool undoCommand( Board *board ) {
+    Move move;
+    if ( !undoMove( &history, &move ) ) {
+        return false;
+    }
+    //Flipping the low bit of a direction gives the opposite one.
+    applyMove( MOVE_DIRECTION( move ) ^ 1, MOVE_TILE( move ), board );
+    return true;
+}
+
+/**
+    This function redoes the most recently undone move.
+    @param board Board pointer to our board.
+    @return bool false if there was no move to redo.
+*/
+static bool redoCommand( Board *board ) {
+    Move move;
+    if ( !redoMove( &history, &move ) ) {
+        return false;
+    }
+    applyMove( MOVE_DIRECTION( move ), MOVE_TILE( move ), board );
+    return true;
+}
+
+/**
+    This function finds a shortest list of moves that solves the board and prints it, one move
+    to a line in the same form as the commands that make them.  The board itself isn't changed.
+    @param board Board pointer to our board.
+    @param threads int the number of threads to search with, or 0 for one per processor.
+    @param seconds int the most seconds to search for, or 0 for no limit.
+    @return void
+*/
+static void printSolution( Board *board, int threads, int seconds ) {
+    static const char *names[] = { UP, DOWN, LEFT, RIGHT };
+    Move moves[ MAX_SOLUTION ];
+    int count = solveBoard( board, threads, seconds, moves );
+    if ( count == SOLVE_EXPIRED ) {
+        printf( "No solution found within limit\n" );
+        return;
+    }
+    if ( count < 0 ) {
+        printf( "No solution found\n" );
+        return;
+    }
+    for ( int i = 0; i < count; i++ ) {
+        printf( "%s %d\n", names[ MOVE_DIRECTION( moves[ i ] ) ], MOVE_TILE( moves[ i ] ) );
+    }
+}
 
 /**
     This function takes a command and determines whether or not that command can be run, and
     if the command can be run, it runs that command.
     @param cmd[ CMD_LIMIT + 1 ] char array holding the command passed by the user.
-    @param rows int the number of rows in our board.
-    @param cols int the number of columns in our board.
-    @param board[][ cols ] int a 2 dimensional array holding the tiles of our board.
+    @param board Board pointer to our board.
     @return bool telling us whether or not the passed command could be run.
 */
-bool runCommand( char cmd[ CMD_LIMIT + 1 ], int rows, int cols, int board[][ cols ] ) {
-    //return true if command is valid (undo and exit are handled in main)
+bool runCommand( char cmd[ CMD_LIMIT + 1 ], Board *board ) {
+    //return true if command is valid (undo, redo and exit are handled in main)
     int val;
     char move[ CMD_LIMIT ];
-    sscanf( cmd, "%s %d", move, &val);
-    bool tileChecker = false;
-    if ( strcmp( move, LEFT ) == 0 || strcmp( move, RIGHT ) == 0 || strcmp( move, UP ) == 0
-            || strcmp( move, DOWN ) == 0 ) {
-        //now perform commands
-        if ( strcmp( move, LEFT ) == 0 ) {
-            tileChecker = moveLeft( val, rows, cols, board );
-        }
-        else if ( strcmp( move, RIGHT ) == 0 ) {
-            tileChecker = moveRight( val, rows, cols, board );
-        }
-        else if ( strcmp( move, UP ) == 0 ) {
-            tileChecker = moveUp( val, rows, cols, board );
-        }
-        else if ( strcmp( move, DOWN ) == 0 ) {
-            tileChecker = moveDown( val, rows, cols, board );
-        }
-        //store command in memory
-        if ( histLen < NUMCOMMANDS ) {
-            strcpy( history[ histLen  ], cmd );
-            histLen++;
-        }
-        //If histLen = 10, drop the oldest command out of memory to add the newest one
-        else {
-            for ( int i = 0; i < NUMCOMMANDS - 1; i++ ) {
-                strcpy( history[ i ], history[ i + 1 ] );
-            }
-            strcpy( history[ histLen - 1 ], cmd );
-            //do not increment histlen because we are at maximum
-        }
+    if ( sscanf( cmd, "%s %d", move, &val) != 2 ) {
+        return false;
+    }
+    Direction direction;
+    if ( strcmp( move, UP ) == 0 ) {
+        direction = MOVE_UP;
+    }
+    else if ( strcmp( move, DOWN ) == 0 ) {
+        direction = MOVE_DOWN;
+    }
+    else if ( strcmp( move, LEFT ) == 0 ) {
+        direction = MOVE_LEFT;
+    }
+    else if ( strcmp( move, RIGHT ) == 0 ) {
+        direction = MOVE_RIGHT;
     }
-    //return false if command is invalid
-    return tileChecker;
+    else {
+        return false;
+    }
+
+    //now perform the move, and store it in memory if the tile was there to move
+    if ( !applyMove( direction, val, board ) ) {
+        return false;
+    }
+    if ( !pushMove( &history, PACK_MOVE( direction, val ) ) ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit(EXIT_ERROR);
+    }
+    return true;
 }
 
 /**
@@ -107,8 +185,33 @@ int main(int argc, char** argv) {
     //Initialize variables for argc and argv so they can be used externally
     int rows = DEFAULT_ROWS;
     int cols = DEFAULT_COLS;
+    int depth = NUMCOMMANDS;
+    int threads = 0;
+    int seconds = SOLVE_SECONDS;
+    bool solveOnly = false;
     FILE *fp;
-    histLen = 0;
+
+    //-d sets how many moves can be undone, with 0 for no limit, -t sets how many threads the
+    //solver uses, with 0 for one per processor, -l sets how many seconds the solver can search
+    //for, with 0 for no limit, and -s just prints how to solve the board the config file leaves.
+    int opt;
+    while ( ( opt = getopt( argc, argv, "d:l:st:" ) ) != -1 ) {
+        char extra;
+        int *value = opt == 'd' ? &depth : opt == 't' ? &threads : opt == 'l' ? &seconds : NULL;
+        if ( opt == 's' ) {
+            solveOnly = true;
+        }
+        else if ( value == NULL || sscanf( optarg, "%d%c", value, &extra ) != 1 || *value < 0 ) {
+            fprintf( stderr, "%s", USAGE );
+            exit(EXIT_ERROR);
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+    if ( !initHistory( &history, depth ) ) {
+        fprintf( stderr, "Out of memory\n" );
+        exit(EXIT_ERROR);
+    }
 
     //check for configuration file.  If it exists, store it in the char array variable "filename."
     //(which we create as a pointer so we don't have to define its size)
@@ -119,7 +222,7 @@ int main(int argc, char** argv) {
         //If there is a command line argument other than the program call and the configuration
         //file, exit with status of 1 and print to standard error.
         if (argc > 2) {
-            fprintf( stderr, "%s", "usage: puzzle [config-file]\n" );
+            fprintf( stderr, "%s", USAGE );
             exit(EXIT_ERROR);
         }
 
@@ -133,7 +236,7 @@ int main(int argc, char** argv) {
         if ( fp == NULL ) {
             fprintf( stderr, "Can't open config file: " );
             fprintf( stderr, "%s", filename );
-            fprintf( stderr, "\nusage: puzzle [config-file]\n" );
+            fprintf( stderr, "\n%s", USAGE );
             exit(EXIT_ERROR);
         }
 
@@ -145,16 +248,19 @@ int main(int argc, char** argv) {
         }
     }
 
-    // Make the board
-    int board[ rows ][ cols ];
+    // Make the board on the heap, since a config file can ask for a very big one
+    Board *board = makeBoard( rows, cols );
+    if ( board == NULL ) {
+        fprintf( stderr, "Invalid configuration\n" );
+        exit(EXIT_ERROR);
+    }
     //initialize board
-    initBoard( rows, cols, board );
+    initBoard( board );
 
     if (argc > 1) {
         //read moves from the configuration file
         char line[ CMD_LIMIT + 2 ];
         char move[ CMD_LIMIT ];
-        int val;
         //use skipline to move to the next line in the file, over the newline char?
         //skipline is in command.c....
         skipLine(fp);
@@ -164,41 +270,28 @@ int main(int argc, char** argv) {
             //check if command has a value with it
             sscanf( line, "%s", move );
 
-            if ( runCommand( line, rows, cols, board ) ) {
+            if ( runCommand( line, board ) ) {
                 //If command is valid but tile is not found, return in error
             }
             //otherwise, figure out what command needs to do
             else if ( strcmp( move, QUIT ) == 0 ) {
+                freeBoard( board );
+                freeHistory( &history );
                 return 0;
             }
             else if ( strcmp( move, UNDO ) == 0 ) {
-                if ( histLen > 0 ) {
-                    char temp[ CMD_LIMIT ];
-                    //put the move value in the last move stored in memory in "move"
-                    //set val = last stored command val
-                    sscanf( history[ histLen - 1 ], "%s %d", temp, &val );
-
-                    //Now reverse the move so it can effectively be "undone"
-                    if ( strcmp( temp, UP ) == 0 ) {
-                        moveDown( val, rows, cols, board );
-                    }
-                    else if ( strcmp( temp, DOWN ) == 0 ) {
-                        moveUp( val, rows, cols, board );
-                    }
-                    else if ( strcmp( temp, RIGHT ) == 0 ) {
-                        moveLeft( val, rows, cols, board );
-                    }
-                    else if ( strcmp( temp, LEFT ) == 0 ) {
-                        moveRight( val, rows, cols, board );
-                    }
-                    //Remove that move from history
-                    strcpy( history[ histLen - 1 ], "" );
-                    histLen--;
+                if ( !undoCommand( board ) ) {
+                    printf("Invalid command\n");
                 }
-                else {
+            }
+            else if ( strcmp( move, REDO ) == 0 ) {
+                if ( !redoCommand( board ) ) {
                     printf("Invalid command\n");
                 }
             }
+            else if ( strcmp( move, SOLVE ) == 0 ) {
+                printSolution( board, threads, seconds );
+            }
 
             //command is invalid
             else {
@@ -209,13 +302,18 @@ int main(int argc, char** argv) {
         //close the configuration file
         fclose(fp);
     }
+    if ( solveOnly ) {
+        printSolution( board, threads, seconds );
+        freeBoard( board );
+        freeHistory( &history );
+        return 0;
+    }
     //print the board
-    printBoard( rows, cols, board );
+    printBoard( board );
     //if no config file, start here
 
         char move[CMD_LIMIT + 2];
         char line[CMD_LIMIT + 2];
-        int val;
 
         while ( fgets( line, sizeof( line ), stdin ) != NULL ) {
             //retrieve the command and value from line implement scanf for undo and exit
@@ -231,37 +329,24 @@ int main(int argc, char** argv) {
             else {
             if ( strcmp( move, QUIT ) == 0 ) {
                 //quit program
+                freeBoard( board );
+                freeHistory( &history );
                 return 0;
             }
             else if ( strcmp( move, UNDO ) == 0 ) {
-                if ( histLen > 0 ) {
-                    char temp[ CMD_LIMIT ];
-                    //put the move value in the last move stored in memory in "move"
-                    //set val = last stored command val
-                    sscanf( history[ histLen - 1 ], "%s %d", temp, &val );
-
-                    //Now reverse the move so it can effectively be "undone"
-                    if ( strcmp( temp, UP ) == 0 ) {
-                        moveDown( val, rows, cols, board );
-                    }
-                    else if ( strcmp( temp, DOWN ) == 0 ) {
-                        moveUp( val, rows, cols, board );
-                    }
-                    else if ( strcmp( temp, RIGHT ) == 0 ) {
-                        moveLeft( val, rows, cols, board );
-                    }
-                    else if ( strcmp( temp, LEFT ) == 0 ) {
-                        moveRight( val, rows, cols, board );
-                    }
-                    //Remove that move from history
-                    strcpy( history[ histLen - 1 ], "" );
-                    histLen--;
+                if ( !undoCommand( board ) ) {
+                    printf("Invalid command\n");
                 }
-                else {
+            }
+            else if ( strcmp( move, REDO ) == 0 ) {
+                if ( !redoCommand( board ) ) {
                     printf("Invalid command\n");
                 }
             }
-            else if ( runCommand( line, rows, cols, board ) ) {
+            else if ( strcmp( move, SOLVE ) == 0 ) {
+                printSolution( board, threads, seconds );
+            }
+            else if ( runCommand( line, board ) ) {
                 //Do nothing, runCommand will run the command
                 //We don't want undo here because it will store the command in memory
             }
@@ -271,7 +356,9 @@ int main(int argc, char** argv) {
             }
             }
             //print board
-            printBoard( rows, cols, board );
+            printBoard( board );
         }
+    freeBoard( board );
+    freeHistory( &history );
     return 0;
 }
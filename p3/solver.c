@@ -0,0 +1,1137 @@
+/**
+    @file solver.c
+    @author W. Scott Spencer
+
+    This file handles solving the puzzle.  The search is iterative deepening A*: depth first
+    searches that give up on any move list whose length plus a lower bound on the moves still
+    needed goes over a cost bound, with the bound raised after each round.  The lower bound
+    comes from how far every tile is from its home row and column, counting distances around
+    the board since rows and columns wrap.  A column move changes the row of one column's worth
+    of tiles by one place each, so the moves up and down can't be fewer than the total row
+    distance divided by the number of rows, nor fewer than the row distance of the farthest
+    tile, and the same goes for row moves and column distances.  Move lists that can't be
+    shortest are never searched at all: a move right after its opposite, moves of the same kind
+    on different lines out of order (they can be made in any order), and more than half a line's
+    length of moves of one line in one direction.  Each round starts by listing every position
+    a couple of moves in, and a pool of threads searches below them, each thread taking
+    positions from its own share first and then stealing from the others once it runs out.
+
+    Each half of the bound is also raised with a pattern database.  The column moves can't be
+    fewer than it takes to bring the tiles of any one row back into that row, in any order, even
+    if row moves cost nothing, and the same goes for row moves and the tiles of a column.  Those
+    counts are found once per solve by a breadth first search, and since moving the whole board
+    around doesn't change how many moves anything takes, one table covers every row and one
+    every column.  Unlike the distances, the tables see that a column move only takes one tile
+    out of each row, so tiles crowded into the same row wait their turn.  Once a solve has run
+    long enough to be worth it, a second set of tables does the same for any two rows at once
+    (or any two columns), so it also sees when the tiles of two rows have to share moves.
+
+    Every move from a position is scored before any is searched, so moves that are sure to go
+    over the bound are dropped without being made, and the rest are searched cheapest first.
+*/
+
+/** Header file containing standard input/output functions we will use. */
+#include <stdio.h>
+/** Header file containing standard library functions we will use. */
+#include <stdlib.h>
+/** Header file containing string functions we will use. */
+#include <string.h>
+/** Header file containing boolean operations we will use. */
+#include <stdbool.h>
+/** Header file containing the INT_MAX limit. */
+#include <limits.h>
+/** Header file containing the POSIX thread functions we will use. */
+#include <pthread.h>
+/** Header file containing the sysconf() function we will use. */
+#include <unistd.h>
+/** Header file containing the clock_gettime() function we will use. */
+#include <time.h>
+/** Header file containing the board type and its functions. */
+#include "board.h"
+/** Header file containing the packed move type. */
+#include "command.h"
+/** Header file containing the function prototype for these functions. */
+#include "solver.h"
+
+/* A constant for the most moves a round is expanded by before it's split up among threads. */
+#define MAX_FRONTIER 3
+/* A constant for the number of positions we'd like each thread to have to search below. */
+#define TASKS_PER_THREAD 16
+/* A constant for about how many tiles a thread moves between checks for a solution, so a big
+   board, where every move is slow, is checked after fewer moves. */
+#define CHECK_TILES 16384
+/* A constant for the bit of a move code that's set for moves toward the start of a line. */
+#define BACKWARD_BIT 1
+/* A constant for the bit of a move code that's set for row moves (and clear for columns). */
+#define ROW_BIT 2
+/* A constant for how far the line of a move code is shifted up. */
+#define LINE_SHIFT 2
+/* A constant for the most lines a pattern table can be made for. */
+#define MAX_PATTERN_LINES 16
+/* A constant for the most entries a pattern table can have. */
+#define MAX_PATTERN_SIZE ( 1 << 22 )
+/* A constant for a pattern database entry that hasn't been reached yet. */
+#define UNREACHED 0xFF
+/* A constant for the most entries a table for a pair of lines can have. */
+#define MAX_PAIR_SIZE ( 1 << 20 )
+/* A constant for how many positions are searched before the pair tables are made. */
+#define PAIR_AFTER 10000
+
+/* A position to search below, given as the moves from the board being solved. */
+typedef struct {
+    /* The move codes that lead to the position. */
+    int moves[ MAX_FRONTIER ];
+    /* The last of those moves. */
+    int last;
+    /* The number of times in a row the last move was made. */
+    int run;
+} Task;
+
+/* A move worth trying from a position in the search, with the bound and the cost of the
+   position it leads to. */
+typedef struct {
+    /* The code of the move. */
+    int code;
+    /* The bound for the move's kind after it's made. */
+    int bound;
+    /* The cost of the position the move leads to. */
+    int cost;
+} Child;
+
+/* One thread's share of the tasks, which it takes from the end of while others steal from the
+   start. */
+typedef struct {
+    /* The index of the first task left in the share. */
+    int head;
+    /* The index just past the last task left in the share. */
+    int tail;
+    /* The lock that keeps the thread and the thieves from taking the same task. */
+    pthread_mutex_t lock;
+} Share;
+
+/* One of the pattern database's tables, which gives the counted moves it takes to bring the
+   tiles of a line back into it, in any order, if moves of the other kind were free.  The table
+   for the rows counts column moves, with the rows as the free lines, and the one for the
+   columns counts row moves, with the columns as the free lines.  With the free lines turning
+   for nothing, all that matters is how many of the tiles are in each of them, so the table is
+   indexed by those counts, with the lines numbered from the tiles' home line. */
+typedef struct {
+    /* The number of free lines. */
+    int lines;
+    /* The length of the free lines, which is also the number of tiles in a pattern. */
+    int length;
+    /* The amount each line's count is multiplied by in an index, a power of length + 1, given
+       twice over so a tile's line less its home line can be looked up without wrapping. */
+    int scale[ 2 * MAX_PATTERN_LINES ];
+    /* The counted moves for each index, or NULL if the board is too big for the table. */
+    uint8_t *moves;
+    /* The number of ways the tiles can be spread over the free lines. */
+    int spreads;
+    /* The index of every spread, in the order the table's search reached them. */
+    uint32_t *order;
+    /* The place of each index in that order, which is how the pair tables number spreads. */
+    uint16_t *rank;
+    /* The pair tables, which are just like the table but for the tiles of two lines at once,
+       numbered by how many lines past the first line's tiles' home the second's is, up to half
+       of the lines.  They're indexed by the first line's spread, times spreads, plus the
+       second's, and NULL if there isn't room for them. */
+    uint8_t *pairs[ MAX_PATTERN_LINES / 2 + 1 ];
+} LineTable;
+
+/* Everything the threads searching one round share. */
+typedef struct {
+    /* The board being solved. */
+    Board *root;
+    /* The cost bound for this round. */
+    int threshold;
+    /* The number of moves in each task. */
+    int depth;
+    /* The positions to search below this round. */
+    Task *tasks;
+    /* Each thread's share of the tasks. */
+    Share *shares;
+    /* The number of threads. */
+    int threads;
+    /* The home row of each tile, and the home column of each tile. */
+    int *home[ 2 ];
+    /* How far a tile is from its home row, or its home column, at the row or column it's in
+       less its home one, plus the number of rows or columns. */
+    int *distance[ 2 ];
+    /* The pattern tables for the rows and for the columns. */
+    LineTable tables[ 2 ];
+    /* The number of moves a thread tries between checks for a solution. */
+    long checkEvery;
+    /* True if the search has to stop by the deadline. */
+    bool limited;
+    /* The time the search has to stop by. */
+    struct timespec deadline;
+    /* The lock guarding the solution and whether the deadline has passed. */
+    pthread_mutex_t lock;
+    /* True once the deadline has passed. */
+    bool expired;
+    /* True once a thread has found a solution. */
+    bool found;
+    /* The number of moves in the solution. */
+    int length;
+    /* The move codes of the solution. */
+    int solution[ MAX_SOLUTION ];
+} SolveJob;
+
+/* One thread's copy of the board and its search state. */
+typedef struct {
+    /* The job the thread is working on. */
+    SolveJob *job;
+    /* The thread's number, which is also the number of its share of tasks. */
+    int id;
+    /* The thread's copy of the board. */
+    Board *board;
+    /* The total distance of every tile from its home row, and from its home column. */
+    int total[ 2 ];
+    /* The number of tiles at each distance from their home row, and from their home column. */
+    int *counts[ 2 ];
+    /* The index in the pattern tables of each row's tiles, and of each column's tiles. */
+    int *index[ 2 ];
+    /* The bound on the moves up and down, and on the moves left and right, that it takes to
+       solve the position being searched. */
+    int bounds[ 2 ];
+    /* Room to keep a copy of the counts for one kind of move while a move is tried on them. */
+    int *saved;
+    /* The moves worth trying from each position on the path, MAX_SOLUTION lists of room for
+       every move. */
+    Child *children;
+    /* The move codes that led to the position being searched. */
+    int path[ MAX_SOLUTION ];
+    /* The smallest cost seen that went over the bound. */
+    int next;
+    /* The number of positions searched. */
+    long nodes;
+    /* The number of moves tried or made, for when to check for a solution. */
+    long tried;
+    /* True once the thread should stop searching. */
+    bool stop;
+} Searcher;
+
+/**
+    This function moves a tile from one row to another, or from one column to another, in the
+    searcher's counts: its distance from its home row or column, and where it stands in its home
+    line's pattern.  A tile coming from nowhere is just added.
+    @param s Searcher pointer to the searcher.
+    @param kind int 0 for the tile's row, or 1 for its column.
+    @param tile int the number of the tile.
+    @param from int the row or column the tile was in, or -1 if it wasn't counted yet.
+    @param to int the row or column the tile is in now.
+    @return void
+*/
+static void moveTile( Searcher *s, int kind, int tile, int from, int to ) {
+    SolveJob *job = s->job;
+    LineTable *table = &job->tables[ kind ];
+    int home = job->home[ kind ][ tile ];
+    int *distance = job->distance[ kind ] + table->lines - home;
+    if ( from >= 0 ) {
+        s->total[ kind ] -= distance[ from ];
+        s->counts[ kind ][ distance[ from ] ]--;
+    }
+    s->total[ kind ] += distance[ to ];
+    s->counts[ kind ][ distance[ to ] ]++;
+    if ( table->moves != NULL ) {
+        int *scale = table->scale + table->lines - home;
+        s->index[ kind ][ home ] += scale[ to ] - ( from >= 0 ? scale[ from ] : 0 );
+    }
+}
+
+/**
+    This function works out the searcher's counts for its board from scratch.
+    @param s Searcher pointer to the searcher.
+    @return void
+*/
+static void countBoard( Searcher *s ) {
+    Board *board = s->board;
+    for ( int kind = 0; kind < 2; kind++ ) {
+        int lines = s->job->tables[ kind ].lines;
+        s->total[ kind ] = 0;
+        memset( s->counts[ kind ], 0, ( lines / 2 + 1 ) * sizeof( int ) );
+        memset( s->index[ kind ], 0, lines * sizeof( int ) );
+    }
+    for ( int r = 0; r < board->rows; r++ ) {
+        for ( int c = 0; c < board->cols; c++ ) {
+            int tile = getTile( board, r, c );
+            moveTile( s, 0, tile, -1, r );
+            moveTile( s, 1, tile, -1, c );
+        }
+    }
+}
+
+/**
+    This function makes a move on a board.  Making the move with its backward bit flipped takes
+    it back.
+    @param board Board pointer to the board.
+    @param code int the code of the move.
+    @return void
+*/
+static void shiftCode( Board *board, int code ) {
+    if ( code & ROW_BIT ) {
+        shiftRow( board, code >> LINE_SHIFT, code & BACKWARD_BIT );
+    }
+    else {
+        shiftColumn( board, code >> LINE_SHIFT, code & BACKWARD_BIT );
+    }
+}
+
+/**
+    This function moves the tiles of a move's line in the searcher's counts, without making the
+    move on the board, or takes that back again.  Only the tiles in the line that moves change,
+    and only their rows for a column move, or their columns for a row move.
+    @param s Searcher pointer to the searcher.
+    @param code int the code of the move.
+    @param back bool true to take the move back out of the counts.
+    @return void
+*/
+static void countCode( Searcher *s, int code, bool back ) {
+    Board *board = s->board;
+    int kind = code & ROW_BIT ? 1 : 0;
+    int line = code >> LINE_SHIFT;
+    int lines = s->job->tables[ kind ].lines;
+    int step = code & BACKWARD_BIT ? lines - 1 : 1;
+    for ( int i = 0; i < lines; i++ ) {
+        int tile = kind ? getTile( board, line, i ) : getTile( board, i, line );
+        int to = i + step < lines ? i + step : i + step - lines;
+        if ( back ) {
+            moveTile( s, kind, tile, to, i );
+        }
+        else {
+            moveTile( s, kind, tile, i, to );
+        }
+    }
+}
+
+/**
+    This function keeps a copy of the searcher's counts for one kind of move, so a move can be
+    tried on them and taken back quickly with restoreCounts().
+    @param s Searcher pointer to the searcher.
+    @param kind int 0 for the rows, or 1 for the columns.
+    @return void
+*/
+static void saveCounts( Searcher *s, int kind ) {
+    int lines = s->job->tables[ kind ].lines;
+    s->saved[ 0 ] = s->total[ kind ];
+    memcpy( s->saved + 1, s->counts[ kind ], ( lines / 2 + 1 ) * sizeof( int ) );
+    memcpy( s->saved + lines / 2 + 2, s->index[ kind ], lines * sizeof( int ) );
+}
+
+/**
+    This function puts back the searcher's counts for one kind of move from the copy
+    saveCounts() kept.
+    @param s Searcher pointer to the searcher.
+    @param kind int 0 for the rows, or 1 for the columns.
+    @return void
+*/
+static void restoreCounts( Searcher *s, int kind ) {
+    int lines = s->job->tables[ kind ].lines;
+    s->total[ kind ] = s->saved[ 0 ];
+    memcpy( s->counts[ kind ], s->saved + 1, ( lines / 2 + 1 ) * sizeof( int ) );
+    memcpy( s->index[ kind ], s->saved + lines / 2 + 2, lines * sizeof( int ) );
+}
+
+/**
+    This function makes a move on the searcher's board, keeping its counts up to date.
+    @param s Searcher pointer to the searcher.
+    @param code int the code of the move.
+    @return void
+*/
+static void applyCode( Searcher *s, int code ) {
+    countCode( s, code, false );
+    shiftCode( s->board, code );
+}
+
+/**
+    This function takes every counted move from one entry of a pattern table and adds every
+    entry that reaches to the table, if the table doesn't have it yet.  A counted move takes
+    one position from each free line over to the line before or after it, and since the free
+    lines can be turned any way first, that can be any one position of each line.  So a move
+    comes down to a choice, for each line, of whether the position it gives up holds one of the
+    pattern's tiles, which it can only if the line has one, or not, which it can only if the
+    line isn't full of them.
+    @param table LineTable pointer to the table.
+    @param index uint32_t the entry to move from.
+    @param queue uint32_t array the new entries are added to the end of.
+    @param tail size_t pointer to the number of entries in the queue.
+    @return void
+*/
+static void expandCounts( LineTable *table, uint32_t index, uint32_t *queue, size_t *tail ) {
+    int lines = table->lines;
+    int moves = table->moves[ index ] + 1;
+    int counts[ MAX_PATTERN_LINES ];
+    for ( int i = 0; i < lines; i++ ) {
+        counts[ i ] = index / table->scale[ i ] % ( table->length + 1 );
+    }
+
+    for ( uint32_t given = 0; given < (uint32_t) 1 << lines; given++ ) {
+        bool possible = true;
+        for ( int i = 0; possible && i < lines; i++ ) {
+            possible = given >> i & 1 ? counts[ i ] > 0 : counts[ i ] < table->length;
+        }
+        for ( int backward = 0; possible && backward < 2; backward++ ) {
+            //Each line gives up its position and takes the one from the line before it, or
+            //from the line after it.
+            int step = backward ? lines - 1 : 1;
+            uint32_t next = index;
+            for ( int i = 0; i < lines; i++ ) {
+                int from = ( i + lines - step ) % lines;
+                next += ( (int) ( given >> from & 1 ) - (int) ( given >> i & 1 ) ) *
+                        table->scale[ i ];
+            }
+            if ( table->moves[ next ] == UNREACHED ) {
+                table->moves[ next ] = moves;
+                queue[ ( *tail )++ ] = next;
+            }
+        }
+    }
+}
+
+/**
+    This function makes one of the pattern database's tables, with a breadth first search out
+    from the pattern's tiles sitting at home in the first line.  Every move can be taken back
+    by another, so the moves it takes to get somewhere from home are the moves it takes to get
+    home from there.  The table is left without moves if the board is too big for it or there
+    isn't enough memory.
+    @param table LineTable pointer to the table, with its lines and length set.
+    @return void
+*/
+static void makeTable( LineTable *table ) {
+    size_t size = 1;
+    for ( int i = 0; i < table->lines; i++ ) {
+        if ( i == MAX_PATTERN_LINES || size > MAX_PATTERN_SIZE / ( table->length + 1 ) ) {
+            return;
+        }
+        table->scale[ i ] = size;
+        size *= table->length + 1;
+    }
+    memcpy( table->scale + table->lines, table->scale, table->lines * sizeof( int ) );
+
+    table->moves = malloc( size );
+    uint32_t *queue = malloc( size * sizeof( uint32_t ) );
+    if ( table->moves == NULL || queue == NULL ) {
+        free( table->moves );
+        free( queue );
+        table->moves = NULL;
+        return;
+    }
+    memset( table->moves, UNREACHED, size );
+    queue[ 0 ] = table->length;
+    table->moves[ queue[ 0 ] ] = 0;
+    size_t tail = 1;
+    for ( size_t head = 0; head < tail; head++ ) {
+        expandCounts( table, queue[ head ], queue, &tail );
+    }
+    table->spreads = tail;
+    table->order = queue;
+}
+
+/**
+    This function takes every counted move from one entry of a pair table and adds every entry
+    that reaches to the table, if the table doesn't have it yet.  It's just like expandCounts(),
+    except that each line's choice is among giving up one of the first line's tiles, one of the
+    second's, or neither.  The choices are run through like the digits of a counter, with the
+    change each one makes to the two lines' indexes kept for both directions.
+    @param table LineTable pointer to the table the pair table is for.
+    @param apart int how many lines past the first line the second line is.
+    @param pairs uint8_t array of counted moves for the pair table.
+    @param entry uint32_t the entry to move from.
+    @param queue uint32_t array the new entries are added to the end of.
+    @param tail size_t pointer to the number of entries in the queue.
+    @return void
+*/
+static void expandPairs( LineTable *table, int apart, uint8_t *pairs, uint32_t entry,
+                         uint32_t *queue, size_t *tail ) {
+    int lines = table->lines;
+    int moves = pairs[ entry ] + 1;
+    uint32_t first = table->order[ entry / table->spreads ];
+    uint32_t second = table->order[ entry % table->spreads ];
+
+    //Each line's choices, and the change each makes to the indexes going forward and back,
+    //with the second line's tiles counted from their own home line.
+    int choices[ MAX_PATTERN_LINES ][ 3 ][ 4 ];
+    int counts[ MAX_PATTERN_LINES ];
+    int digits[ MAX_PATTERN_LINES ];
+    int change[ 4 ] = { 0, 0, 0, 0 };
+    for ( int i = 0; i < lines; i++ ) {
+        int j = ( i + lines - apart ) % lines;
+        int mine = first / table->scale[ i ] % ( table->length + 1 );
+        int theirs = second / table->scale[ j ] % ( table->length + 1 );
+        counts[ i ] = 0;
+        if ( mine + theirs < table->length ) {
+            int *choice = choices[ i ][ counts[ i ]++ ];
+            memset( choice, 0, 4 * sizeof( int ) );
+        }
+        if ( mine > 0 ) {
+            int *choice = choices[ i ][ counts[ i ]++ ];
+            choice[ 0 ] = table->scale[ i + 1 ] - table->scale[ i ];
+            choice[ 1 ] = table->scale[ i + lines - 1 ] - table->scale[ i ];
+            choice[ 2 ] = choice[ 3 ] = 0;
+        }
+        if ( theirs > 0 ) {
+            int *choice = choices[ i ][ counts[ i ]++ ];
+            choice[ 0 ] = choice[ 1 ] = 0;
+            choice[ 2 ] = table->scale[ j + 1 ] - table->scale[ j ];
+            choice[ 3 ] = table->scale[ j + lines - 1 ] - table->scale[ j ];
+        }
+        digits[ i ] = 0;
+        for ( int k = 0; k < 4; k++ ) {
+            change[ k ] += choices[ i ][ 0 ][ k ];
+        }
+    }
+
+    int i = 0;
+    while ( i < lines ) {
+        for ( int d = 0; d < 2; d++ ) {
+            uint32_t next = table->rank[ first + change[ d ] ] * table->spreads +
+                            table->rank[ second + change[ d + 2 ] ];
+            if ( pairs[ next ] == UNREACHED ) {
+                pairs[ next ] = moves;
+                queue[ ( *tail )++ ] = next;
+            }
+        }
+
+        //Move on to the next set of choices, carrying into the next line when one runs out.
+        for ( i = 0; i < lines; i++ ) {
+            int *old = choices[ i ][ digits[ i ] ];
+            digits[ i ] = digits[ i ] + 1 < counts[ i ] ? digits[ i ] + 1 : 0;
+            int *new = choices[ i ][ digits[ i ] ];
+            for ( int k = 0; k < 4; k++ ) {
+                change[ k ] += new[ k ] - old[ k ];
+            }
+            if ( digits[ i ] > 0 ) {
+                break;
+            }
+        }
+    }
+}
+
+/**
+    This function makes the pair tables for one of the pattern database's tables, each with a
+    breadth first search out from the two lines' tiles sitting at home, unless they've already
+    been made.  If there isn't room for all of them, none are made.
+    @param table LineTable pointer to the table.
+    @return void
+*/
+static void makePairs( LineTable *table ) {
+    size_t size = (size_t) table->spreads * table->spreads;
+    if ( table->moves == NULL || table->rank != NULL || size > MAX_PAIR_SIZE ) {
+        return;
+    }
+    table->rank = malloc( table->scale[ table->lines - 1 ] * ( table->length + 1 ) *
+                          sizeof( uint16_t ) );
+    uint32_t *queue = malloc( size * sizeof( uint32_t ) );
+    if ( table->rank == NULL || queue == NULL ) {
+        free( queue );
+        return;
+    }
+    for ( int i = 0; i < table->spreads; i++ ) {
+        table->rank[ table->order[ i ] ] = i;
+    }
+
+    bool ready = true;
+    for ( int apart = 1; apart <= table->lines / 2; apart++ ) {
+        table->pairs[ apart ] = malloc( size );
+        ready = ready && table->pairs[ apart ] != NULL;
+    }
+    for ( int apart = 1; apart <= table->lines / 2; apart++ ) {
+        uint8_t *pairs = table->pairs[ apart ];
+        if ( !ready ) {
+            free( pairs );
+            table->pairs[ apart ] = NULL;
+            continue;
+        }
+        memset( pairs, UNREACHED, size );
+        queue[ 0 ] = 0;
+        pairs[ 0 ] = 0;
+        size_t tail = 1;
+        for ( size_t head = 0; head < tail; head++ ) {
+            expandPairs( table, apart, pairs, queue[ head ], queue, &tail );
+        }
+    }
+    free( queue );
+}
+
+/**
+    This function checks whether the deadline has passed, and remembers it if it has.  While the
+    threads are searching, the job's lock has to be held.
+    @param job SolveJob pointer to the job.
+    @return bool true if the deadline has passed.
+*/
+static bool pastDeadline( SolveJob *job ) {
+    struct timespec now;
+    if ( job->limited && !job->expired && clock_gettime( CLOCK_MONOTONIC, &now ) == 0 ) {
+        job->expired = now.tv_sec > job->deadline.tv_sec ||
+                       ( now.tv_sec == job->deadline.tv_sec &&
+                         now.tv_nsec >= job->deadline.tv_nsec );
+    }
+    return job->expired;
+}
+
+/**
+    This function sets up everything about the board being solved that the threads share: the
+    home row and column of every tile, the distances of every row and column from one another,
+    and the pattern database, which has a table for the rows, counting column moves, and one
+    for the columns, counting row moves.
+    @param job SolveJob pointer to the job.
+    @return bool false if there isn't enough memory, or the deadline passed first.
+*/
+static bool prepareJob( SolveJob *job ) {
+    int rows = job->root->rows;
+    int cols = job->root->cols;
+    job->tables[ 0 ].lines = rows;
+    job->tables[ 0 ].length = cols;
+    job->tables[ 1 ].lines = cols;
+    job->tables[ 1 ].length = rows;
+    for ( int kind = 0; kind < 2; kind++ ) {
+        int lines = job->tables[ kind ].lines;
+        job->home[ kind ] = malloc( ( rows * cols + 1 ) * sizeof( int ) );
+        job->distance[ kind ] = malloc( 2 * lines * sizeof( int ) );
+        if ( job->home[ kind ] == NULL || job->distance[ kind ] == NULL ) {
+            return false;
+        }
+        for ( int tile = 1; tile <= rows * cols; tile++ ) {
+            job->home[ kind ][ tile ] = kind ? ( tile - 1 ) % cols : ( tile - 1 ) / cols;
+        }
+        for ( int d = 1 - lines; d < lines; d++ ) {
+            int away = abs( d );
+            job->distance[ kind ][ d + lines ] = away < lines - away ? away : lines - away;
+        }
+        if ( pastDeadline( job ) ) {
+            return false;
+        }
+        makeTable( &job->tables[ kind ] );
+    }
+    return !pastDeadline( job );
+}
+
+/**
+    This function frees everything the job allocated.
+    @param job SolveJob pointer to the job.
+    @return void
+*/
+static void freeJob( SolveJob *job ) {
+    for ( int kind = 0; kind < 2; kind++ ) {
+        free( job->home[ kind ] );
+        free( job->distance[ kind ] );
+        LineTable *table = &job->tables[ kind ];
+        free( table->moves );
+        free( table->order );
+        free( table->rank );
+        for ( int apart = 0; apart <= MAX_PATTERN_LINES / 2; apart++ ) {
+            free( table->pairs[ apart ] );
+        }
+    }
+    free( job->tasks );
+    free( job->shares );
+}
+
+/**
+    This function returns a lower bound on the moves up and down, or on the moves left and
+    right, it takes to solve the searcher's board.  The bound is the best of the ones from the
+    distances and from the pattern database, with the pair tables only looked at while the
+    bound is still within the budget.
+    @param s Searcher pointer to the searcher.
+    @param kind int 0 for the moves up and down, or 1 for the moves left and right.
+    @param budget int the most moves of the kind there are to spend.
+    @return int the lower bound, which might not be the best one once it's over the budget.
+*/
+static int kindBound( Searcher *s, int kind, int budget ) {
+    LineTable *table = &s->job->tables[ kind ];
+    int lines = table->lines;
+    int *index = s->index[ kind ];
+    int farthest = lines / 2;
+    while ( farthest > 0 && s->counts[ kind ][ farthest ] == 0 ) {
+        farthest--;
+    }
+    int moves = ( s->total[ kind ] + lines - 1 ) / lines;
+    moves = farthest > moves ? farthest : moves;
+    for ( int home = 0; table->moves != NULL && home < lines; home++ ) {
+        int needed = table->moves[ index[ home ] ];
+        moves = needed > moves ? needed : moves;
+    }
+    if ( moves > budget || table->pairs[ 1 ] == NULL ) {
+        return moves;
+    }
+
+    int ranks[ MAX_PATTERN_LINES ];
+    for ( int home = 0; home < lines; home++ ) {
+        ranks[ home ] = table->rank[ index[ home ] ];
+    }
+    for ( int first = 0; moves <= budget && first < lines; first++ ) {
+        for ( int second = first + 1; second < lines; second++ ) {
+            //A pair further apart than half way is the same as the pair the other way around.
+            int apart = second - first;
+            int needed = apart <= lines / 2 ?
+                table->pairs[ apart ][ ranks[ first ] * table->spreads + ranks[ second ] ] :
+                table->pairs[ lines - apart ][ ranks[ second ] * table->spreads + ranks[ first ] ];
+            moves = needed > moves ? needed : moves;
+        }
+    }
+    return moves;
+}
+
+/**
+    This function works out the searcher's bounds from scratch and returns a lower bound on the
+    number of moves it takes to solve its board.  The moves up and down and the moves left and
+    right are bounded separately, since every move is one or the other.
+    @param s Searcher pointer to the searcher.
+    @return int the lower bound.
+*/
+static int heuristic( Searcher *s ) {
+    s->bounds[ 0 ] = kindBound( s, 0, INT_MAX );
+    s->bounds[ 1 ] = kindBound( s, 1, INT_MAX );
+    return s->bounds[ 0 ] + s->bounds[ 1 ];
+}
+
+/**
+    This function decides whether a move is worth trying after the moves before it.
+    @param board Board pointer to our board.
+    @param last int the code of the last move made, or -1 if there wasn't one.
+    @param run int the number of times in a row the last move was made.
+    @param code int the code of the move.
+    @return bool false if some move list at least as short does the same thing and will be
+                 searched anyway.
+*/
+static bool allowed( Board *board, int last, int run, int code ) {
+    //Rotating a line k places one way is the same as rotating it length - k places the other,
+    //so only go up to half way, and only backward when it's exactly half.
+    int length = code & ROW_BIT ? board->cols : board->rows;
+    int limit = code & BACKWARD_BIT ? length / 2 : ( length - 1 ) / 2;
+
+    //Moves of the same kind on different lines can be made in either order, so make them in
+    //order of their lines, and never follow a move with its opposite.
+    if ( last >= 0 && ( ( last ^ code ) & ROW_BIT ) == 0 ) {
+        int line = code >> LINE_SHIFT;
+        int lastLine = last >> LINE_SHIFT;
+        if ( line < lastLine ) {
+            return false;
+        }
+        if ( line == lastLine ) {
+            return code == last && run < limit;
+        }
+    }
+    return limit > 0;
+}
+
+/**
+    This function records a solution the searcher found, unless another thread found one first.
+    @param s Searcher pointer to the searcher.
+    @param length int the number of moves in the solution.
+    @return void
+*/
+static void finish( Searcher *s, int length ) {
+    SolveJob *job = s->job;
+    pthread_mutex_lock( &job->lock );
+    if ( !job->found ) {
+        job->found = true;
+        job->length = length;
+        memcpy( job->solution, s->path, length * sizeof( int ) );
+    }
+    pthread_mutex_unlock( &job->lock );
+    s->stop = true;
+}
+
+/**
+    This function checks whether another thread has found a solution or the deadline has
+    passed, so this one can stop.
+    @param s Searcher pointer to the searcher.
+    @return bool true if the searcher should stop.
+*/
+static bool stopped( Searcher *s ) {
+    SolveJob *job = s->job;
+    pthread_mutex_lock( &job->lock );
+    s->stop = pastDeadline( job ) || job->found;
+    pthread_mutex_unlock( &job->lock );
+    return s->stop;
+}
+
+/**
+    This function searches every move list below the searcher's position whose cost is within
+    the round's bound.  Each move is tried on the counts first, and only made on the board if
+    the position it leads to is within the bound, since most of them aren't.  A move only
+    changes the bound for its own kind, so the other one is kept.  The moves that are left are
+    made cheapest first, which finds the solution sooner in the last round.
+    @param s Searcher pointer to the searcher, with its board at the position and its bounds
+             set for it, and the position's cost within the round's bound.
+    @param g int the number of moves made to get to the position.
+    @param last int the code of the last move made, or -1 if there wasn't one.
+    @param run int the number of times in a row the last move was made.
+    @return bool true if a solution was found.
+*/
+static bool search( Searcher *s, int g, int last, int run ) {
+    int threshold = s->job->threshold;
+    if ( checkSolved( s->board ) ) {
+        finish( s, g );
+        return true;
+    }
+    s->nodes++;
+    if ( ( ++s->tried % s->job->checkEvery == 0 && stopped( s ) ) || g == MAX_SOLUTION ) {
+        return false;
+    }
+
+    int lines[] = { s->board->cols, s->board->rows };
+    Child *children = s->children + (size_t) g * 2 * ( lines[ 0 ] + lines[ 1 ] );
+    int count = 0;
+    for ( int kind = 0; kind < 2; kind++ ) {
+        for ( int line = 0; line < lines[ kind ]; line++ ) {
+            for ( int backward = 0; backward < 2; backward++ ) {
+                int code = line << LINE_SHIFT | kind * ROW_BIT | backward;
+                if ( !allowed( s->board, last, run, code ) ) {
+                    continue;
+                }
+
+                //Trying every move from a position on a big board takes a while, so the
+                //deadline is checked between tries too.
+                if ( ++s->tried % s->job->checkEvery == 0 && stopped( s ) ) {
+                    return false;
+                }
+                int other = s->bounds[ !kind ];
+                saveCounts( s, kind );
+                countCode( s, code, false );
+                int bound = kindBound( s, kind, threshold - g - 1 - other );
+                restoreCounts( s, kind );
+                int f = g + 1 + bound + other;
+                if ( f > threshold ) {
+                    if ( f < s->next ) {
+                        s->next = f;
+                    }
+                    continue;
+                }
+
+                //Keep the moves in order of cost, and in the order they were found for a tie.
+                int i = count++;
+                while ( i > 0 && children[ i - 1 ].cost > f ) {
+                    children[ i ] = children[ i - 1 ];
+                    i--;
+                }
+                children[ i ] = ( Child ) { code, bound, f };
+            }
+        }
+    }
+
+    for ( int i = 0; i < count; i++ ) {
+        int code = children[ i ].code;
+        int kind = code & ROW_BIT ? 1 : 0;
+        int kept = s->bounds[ kind ];
+        countCode( s, code, false );
+        shiftCode( s->board, code );
+        s->bounds[ kind ] = children[ i ].bound;
+        s->path[ g ] = code;
+        if ( search( s, g + 1, code, code == last ? run + 1 : 1 ) ) {
+            return true;
+        }
+        applyCode( s, code ^ BACKWARD_BIT );
+        s->bounds[ kind ] = kept;
+        if ( s->stop ) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+    This function lists the positions a round's threads will search below: every position
+    job->depth moves from the board being solved whose cost is within the round's bound.
+    @param s Searcher pointer to the searcher doing the listing, with its board at a position.
+    @param g int the number of moves made to get to the position.
+    @param last int the code of the last move made, or -1 if there wasn't one.
+    @param run int the number of times in a row the last move was made.
+    @param count int pointer to the number of tasks listed so far.
+    @return void
+*/
+static void listTasks( Searcher *s, int g, int last, int run, int *count ) {
+    SolveJob *job = s->job;
+
+    //On a big board there are so many moves that listing them takes a while, so the deadline
+    //is checked here too.  No other thread is searching yet, so there's no lock to take.
+    s->nodes++;
+    if ( ++s->tried % job->checkEvery == 0 && pastDeadline( job ) ) {
+        return;
+    }
+    int f = g + heuristic( s );
+    if ( f > job->threshold ) {
+        if ( f < s->next ) {
+            s->next = f;
+        }
+        return;
+    }
+    if ( g == job->depth ) {
+        Task *task = &job->tasks[ *count ];
+        memcpy( task->moves, s->path, g * sizeof( int ) );
+        task->last = last;
+        task->run = run;
+        ( *count )++;
+        return;
+    }
+
+    int lines[] = { s->board->cols, s->board->rows };
+    for ( int kind = 0; kind < 2; kind++ ) {
+        for ( int line = 0; line < lines[ kind ]; line++ ) {
+            for ( int backward = 0; backward < 2; backward++ ) {
+                int code = line << LINE_SHIFT | kind * ROW_BIT | backward;
+                if ( allowed( s->board, last, run, code ) ) {
+                    applyCode( s, code );
+                    s->path[ g ] = code;
+                    listTasks( s, g + 1, code, code == last ? run + 1 : 1, count );
+                    applyCode( s, code ^ BACKWARD_BIT );
+                    if ( job->expired ) {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+    This function takes the next task for a thread, from the end of its own share if there's
+    anything left in it, and otherwise from the start of another thread's share.
+    @param job SolveJob pointer to the job.
+    @param id int the thread's number.
+    @param task int pointer the index of the task is stored in.
+    @return bool false if there are no tasks left anywhere.
+*/
+static bool takeTask( SolveJob *job, int id, int *task ) {
+    for ( int i = 0; i < job->threads; i++ ) {
+        Share *share = &job->shares[ ( id + i ) % job->threads ];
+        pthread_mutex_lock( &share->lock );
+        bool taken = share->head < share->tail;
+        if ( taken ) {
+            *task = i == 0 ? --share->tail : share->head++;
+        }
+        pthread_mutex_unlock( &share->lock );
+        if ( taken ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+    This function is run by each thread in the pool.  It keeps taking tasks and searching below
+    them until there are none left or some thread finds a solution.
+    @param arg void pointer to the thread's Searcher.
+    @return void pointer that is always NULL.
+*/
+static void *searchTasks( void *arg ) {
+    Searcher *s = arg;
+    SolveJob *job = s->job;
+    int index;
+    while ( !stopped( s ) && takeTask( job, s->id, &index ) ) {
+        //Set the thread's board up at the task's position, then search below it.
+        Task *task = &job->tasks[ index ];
+        copyBoard( s->board, job->root );
+        for ( int i = 0; i < job->depth; i++ ) {
+            shiftCode( s->board, task->moves[ i ] );
+            s->path[ i ] = task->moves[ i ];
+        }
+        countBoard( s );
+        heuristic( s );
+        search( s, job->depth, task->last, task->run );
+    }
+    return NULL;
+}
+
+/**
+    This function frees the searchers' boards and counts.
+    @param searchers Searcher array to free.
+    @param count int the number of searchers.
+    @return void
+*/
+static void freeSearchers( Searcher *searchers, int count ) {
+    for ( int i = 0; i < count; i++ ) {
+        if ( searchers[ i ].board != NULL ) {
+            freeBoard( searchers[ i ].board );
+        }
+        for ( int kind = 0; kind < 2; kind++ ) {
+            free( searchers[ i ].counts[ kind ] );
+            free( searchers[ i ].index[ kind ] );
+        }
+        free( searchers[ i ].saved );
+        free( searchers[ i ].children );
+    }
+    free( searchers );
+}
+
+/**
+    This function searches one round with the pool of threads, listing the tasks and then
+    splitting them up evenly among the threads for them to start on.
+    @param job SolveJob pointer to the job, with its threshold set for the round.
+    @param searchers Searcher array with one searcher for each thread.
+    @return void
+*/
+static void searchRound( SolveJob *job, Searcher *searchers ) {
+    Searcher *first = &searchers[ 0 ];
+    copyBoard( first->board, job->root );
+    countBoard( first );
+    int count = 0;
+    listTasks( first, 0, -1, 0, &count );
+
+    for ( int i = 0; i < job->threads; i++ ) {
+        job->shares[ i ].head = (long) count * i / job->threads;
+        job->shares[ i ].tail = (long) count * ( i + 1 ) / job->threads;
+    }
+
+    //If a thread can't be started, the others will just steal its share.
+    pthread_t *ids = malloc( job->threads * sizeof( pthread_t ) );
+    bool *started = calloc( job->threads, sizeof( bool ) );
+    for ( int i = 1; ids != NULL && started != NULL && i < job->threads; i++ ) {
+        started[ i ] = pthread_create( &ids[ i ], NULL, searchTasks, &searchers[ i ] ) == 0;
+    }
+    searchTasks( first );
+    for ( int i = 1; ids != NULL && started != NULL && i < job->threads; i++ ) {
+        if ( started[ i ] ) {
+            pthread_join( ids[ i ], NULL );
+        }
+    }
+    free( ids );
+    free( started );
+}
+
+/**
+    This function is documented in solver.h.
+*/
+int solveBoard( Board *board, int threads, int seconds, Move *moves ) {
+    if ( threads == 0 ) {
+        threads = sysconf( _SC_NPROCESSORS_ONLN );
+    }
+    if ( threads < 1 ) {
+        threads = 1;
+    }
+
+    SolveJob job;
+    job.root = board;
+    job.threads = threads;
+    job.found = false;
+    job.expired = false;
+    job.length = SOLVE_FAILED;
+    job.limited = seconds > 0 && clock_gettime( CLOCK_MONOTONIC, &job.deadline ) == 0;
+    job.deadline.tv_sec += seconds;
+    int most = board->rows > board->cols ? board->rows : board->cols;
+    job.checkEvery = CHECK_TILES / most > 0 ? CHECK_TILES / most : 1;
+    for ( int kind = 0; kind < 2; kind++ ) {
+        job.home[ kind ] = NULL;
+        job.distance[ kind ] = NULL;
+        memset( &job.tables[ kind ], 0, sizeof( job.tables[ kind ] ) );
+    }
+
+    //List tasks deep enough for every thread to get a good number of them.
+    int kinds = 2 * ( board->rows + board->cols );
+    int tasks = kinds;
+    job.depth = 1;
+    while ( job.depth < MAX_FRONTIER && tasks < threads * TASKS_PER_THREAD ) {
+        job.depth++;
+        tasks *= kinds;
+    }
+
+    //Give every thread its own board to search on.  Setting up a big board takes long enough
+    //that the deadline is checked between each step.
+    Searcher *searchers = calloc( threads, sizeof( Searcher ) );
+    job.tasks = malloc( tasks * sizeof( Task ) );
+    job.shares = malloc( threads * sizeof( Share ) );
+    bool ready = searchers != NULL && job.tasks != NULL && job.shares != NULL;
+    for ( int i = 0; ready && !pastDeadline( &job ) && i < threads; i++ ) {
+        searchers[ i ].job = &job;
+        searchers[ i ].id = i;
+        searchers[ i ].board = makeBoard( board->rows, board->cols );
+        ready = searchers[ i ].board != NULL;
+        for ( int kind = 0; ready && kind < 2; kind++ ) {
+            int lines = kind ? board->cols : board->rows;
+            searchers[ i ].counts[ kind ] = malloc( ( lines / 2 + 1 ) * sizeof( int ) );
+            searchers[ i ].index[ kind ] = malloc( lines * sizeof( int ) );
+            ready = searchers[ i ].counts[ kind ] != NULL && searchers[ i ].index[ kind ] != NULL;
+        }
+        searchers[ i ].saved = malloc( ( most / 2 + 2 + most ) * sizeof( int ) );
+        size_t children = (size_t) MAX_SOLUTION * 2 * ( board->rows + board->cols );
+        searchers[ i ].children = malloc( children * sizeof( Child ) );
+        ready = ready && searchers[ i ].saved != NULL && searchers[ i ].children != NULL;
+    }
+    if ( !ready || job.expired || !prepareJob( &job ) ) {
+        if ( searchers != NULL ) {
+            freeSearchers( searchers, threads );
+        }
+        freeJob( &job );
+        return job.expired ? SOLVE_EXPIRED : SOLVE_FAILED;
+    }
+    pthread_mutex_init( &job.lock, NULL );
+    for ( int i = 0; i < threads; i++ ) {
+        pthread_mutex_init( &job.shares[ i ].lock, NULL );
+    }
+
+    //Raise the bound a round at a time until a round finds a solution.  The bound never goes
+    //past the length of the shortest solution, so the first one found is a shortest one.
+    Searcher *first = &searchers[ 0 ];
+    copyBoard( first->board, board );
+    countBoard( first );
+    job.threshold = heuristic( first );
+    while ( job.threshold <= MAX_SOLUTION && !pastDeadline( &job ) ) {
+        for ( int i = 0; i < threads; i++ ) {
+            searchers[ i ].next = INT_MAX;
+            searchers[ i ].stop = false;
+        }
+
+        //Rounds too short to split up are searched by this thread alone.
+        if ( job.threshold <= job.depth ) {
+            copyBoard( first->board, board );
+            countBoard( first );
+            heuristic( first );
+            search( first, 0, -1, 0 );
+        }
+        else {
+            searchRound( &job, searchers );
+        }
+        if ( job.found || job.expired ) {
+            break;
+        }
+
+        //Once the search has shown it's going to take a while, the pair tables are worth the
+        //time it takes to make them.
+        long searched = 0;
+        for ( int i = 0; i < threads; i++ ) {
+            searched += searchers[ i ].nodes;
+        }
+        if ( searched >= PAIR_AFTER && !pastDeadline( &job ) ) {
+            makePairs( &job.tables[ 0 ] );
+        }
+        if ( searched >= PAIR_AFTER && !pastDeadline( &job ) ) {
+            makePairs( &job.tables[ 1 ] );
+        }
+
+        job.threshold = INT_MAX;
+        for ( int i = 0; i < threads; i++ ) {
+            if ( searchers[ i ].next < job.threshold ) {
+                job.threshold = searchers[ i ].next;
+            }
+        }
+    }
+
+    //Replay the solution to find a tile in each line as it's moved.
+    if ( job.found ) {
+        Board *replay = first->board;
+        copyBoard( replay, board );
+        for ( int i = 0; i < job.length; i++ ) {
+            int code = job.solution[ i ];
+            int line = code >> LINE_SHIFT;
+            bool backward = code & BACKWARD_BIT;
+            if ( code & ROW_BIT ) {
+                moves[ i ] = PACK_MOVE( backward ? MOVE_LEFT : MOVE_RIGHT,
+                                        getTile( replay, line, 0 ) );
+            }
+            else {
+                moves[ i ] = PACK_MOVE( backward ? MOVE_UP : MOVE_DOWN,
+                                        getTile( replay, 0, line ) );
+            }
+            shiftCode( replay, code );
+        }
+    }
+
+    for ( int i = 0; i < threads; i++ ) {
+        pthread_mutex_destroy( &job.shares[ i ].lock );
+    }
+    pthread_mutex_destroy( &job.lock );
+    freeSearchers( searchers, threads );
+    freeJob( &job );
+    return job.found ? job.length : job.expired ? SOLVE_EXPIRED : SOLVE_FAILED;
+}
@@ -0,0 +1,35 @@
+/**
+    @file solver.h
+    @author W. Scott Spencer
+
+    This file is a header file containing the function prototype for the solver, which finds a
+    shortest list of moves that puts a scrambled board back in its solved state.  It uses the
+    Board type from board.h and the packed Move type from command.h, so both of those have to be
+    included first.
+*/
+
+/* A constant for the longest solution the solver will look for. */
+#define MAX_SOLUTION 64
+/* A constant the solver returns when there's no solution within MAX_SOLUTION moves or there
+   isn't enough memory to search. */
+#define SOLVE_FAILED -1
+/* A constant the solver returns when it runs out of time before it finds a solution. */
+#define SOLVE_EXPIRED -2
+
+/**
+    This function finds a shortest list of moves that solves the board, with an iterative
+    deepening A* search.  Each round of the search looks at every move list up to a cost bound,
+    which a heuristic that never overestimates keeps as small as it can be, and the bound is
+    raised to the cheapest move list that went over it until one solves the board.  The work in
+    each round is split up among a pool of threads.  Every move is given as a tile in the row or
+    column that moves, which is the tile a user would type in the command.
+
+    @param board Board pointer to the board to solve, which is left as it was.
+    @param threads int the number of threads to search with, or 0 for one per online processor.
+    @param seconds int the most seconds to spend, setup included, or 0 for no limit.
+    @param moves Move pointer that the packed moves are stored in, with room for MAX_SOLUTION.
+    @return int the number of moves in the solution, SOLVE_EXPIRED if the time ran out first, or
+                SOLVE_FAILED if there's no solution within MAX_SOLUTION moves or there isn't
+                enough memory to search.
+*/
+int solveBoard( Board *board, int threads, int seconds, Move *moves );
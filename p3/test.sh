@@ -85,6 +85,11 @@ if [ -x puzzle ] ; then
     testPuzzle 17 1 missing-file.txt
     testPuzzle 18 1 config-18.txt
     testPuzzle 19 1 config-19.txt
+    testPuzzle 20 0
+    testPuzzle 21 0 -d 2
+    testPuzzle 22 0
+    testPuzzle 23 0 config-23.txt
+    testPuzzle 24 0 config-24.txt
 else
     echo "**** Your program didn't compile successfully, so we couldn't test it."
     FAIL=1